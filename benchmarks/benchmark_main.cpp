@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "harness.h"
+#include "instruction_benchmarks.h"
+#include "parser_benchmarks.h"
+#include "workload_benchmarks.h"
+#include "source_generator.h"
+
+static void print_usage() {
+    std::cerr
+        << "svim_benchmarks [--json] [--runs=N] [--warmup=N] [--filter=TEXT] [--max-source-mb=N] [--workloads=DIR]\n"
+        << "svim_benchmarks --generate=FILE [--source-size=N] [--seed=N]\n"
+        << "    --json              print results as a JSON object once every benchmark has run\n"
+        << "    --runs              measured runs per benchmark (default 21)\n"
+        << "    --warmup            unmeasured runs before those (default 3)\n"
+        << "    --filter            only run benchmarks whose names contain TEXT\n"
+        << "    --max-source-mb     largest generated source the parser benchmarks read, up to 1024 (default 64)\n"
+        << "    --workloads         directory holding the workload programs and their expected_output.txt (default benchmarks/workloads)\n"
+        << "    --generate          write a generated SVIM program into FILE instead of benchmarking\n"
+        << "    --source-size       bytes --generate writes, at least (default 1048576)\n"
+        << "    --seed              seed --generate writes with; the same seed writes the same program (default 1)\n";
+}
+
+static bool parse_count(std::string_view value, int& out_count) {
+    const auto [end, error] { std::from_chars(value.data(), value.data() + value.size(), out_count) };
+    return (error == std::errc {}) && (end == value.data() + value.size()) && (out_count >= 0);
+}
+
+static int generate_source(const std::string& file_name, int bytes, int seed) {
+    std::ofstream output { file_name, std::ios::binary };
+
+    if (!output.is_open()) {
+        std::cerr << "Could not open \"" << file_name << "\" for writing.\n";
+        return 1;
+    }
+
+    bench::Source_Generator generator { static_cast<std::uint32_t>(seed) };
+    const std::uint64_t instructions { generator.write(output, static_cast<std::uint64_t>(bytes)) };
+    std::cout << "Wrote " << instructions << " instructions into \"" << file_name << "\"\n";
+    return 0;
+}
+
+int main(int argc, const char* argv[]) {
+    bench::Settings settings {};
+    int largest_source_megabytes { 64 };
+    std::string generated_file {};
+    int source_size { 1 << 20 };
+    int seed { 1 };
+    std::string workload_directory { "benchmarks/workloads" };
+
+    for (int i { 1 }; i < argc; ++i) {
+        const std::string_view arg { argv[i] };
+
+        if (arg == "--json") {
+            settings.format = bench::Format::json;
+        }
+        else if (arg.starts_with("--runs=") && parse_count(arg.substr(7), settings.measured_runs)) {}
+        else if (arg.starts_with("--warmup=") && parse_count(arg.substr(9), settings.warmup_runs)) {}
+        else if (arg.starts_with("--filter=")) {
+            settings.filter = arg.substr(9);
+        }
+        else if (arg.starts_with("--max-source-mb=") && parse_count(arg.substr(16), largest_source_megabytes)) {}
+        else if (arg.starts_with("--workloads=")) {
+            workload_directory = arg.substr(12);
+        }
+        else if (arg.starts_with("--generate=")) {
+            generated_file = arg.substr(11);
+        }
+        else if (arg.starts_with("--source-size=") && parse_count(arg.substr(14), source_size)) {}
+        else if (arg.starts_with("--seed=") && parse_count(arg.substr(7), seed)) {}
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!generated_file.empty()) {
+        return generate_source(generated_file, source_size, seed);
+    }
+
+    bench::Harness harness { settings, std::cout };
+
+    try {
+        /* Instructions */ {
+            bench::run_instruction_benchmarks(harness);
+            bench::run_control_flow_benchmarks(harness);
+            bench::run_dispatch_benchmarks(harness);
+        }
+
+        /* Parser */ {
+            bench::run_parser_benchmarks(harness, static_cast<std::uint64_t>(largest_source_megabytes) << 20);
+        }
+
+        /* Workloads */ {
+            bench::run_workload_benchmarks(harness, workload_directory);
+        }
+    }
+    catch (const std::exception& exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    harness.finish();
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "instruction_benchmarks.h"
+#include "virtual_machine/virtual_machine.h"
+#include "virtual_machine/instructions.h"
+#include "interpreter/application.h"
+
+#include <functional>
+
+namespace bench {
+    using namespace svim;
+
+    //----------- Internal Types
+
+    // Appends one copy of a loop body to the end of [code]. Bodies must leave the stack as they found it.
+    using Body_Writer = std::function<void(std::vector<int>& code)>;
+
+    struct Loop_Program final {
+        // Placed at index 0, ahead of the loop, so "CALL" can name them by index.
+        std::vector<int> functions {};
+        // Runs once before the loop, such as to push values for the body to work on.
+        std::vector<int> setup {};
+        // Written g_body_repeats times per iteration. Empty for a loop that only counts.
+        Body_Writer body {};
+    };
+
+
+    //----------- Internal Data
+
+    static constexpr int g_loop_iterations { 20'000 };
+    static constexpr int g_body_repeats { 16 };
+    // The loop counter. Bodies use other locals.
+    static constexpr int g_counter_local { 0 };
+
+    // Magic numbers for dividing by 7, as Optimizer computes them. ("Hacker's Delight," Table 10-1.)
+    static constexpr int g_divisor { 7 };
+    static constexpr int g_divisor_magic { -1840700269 };
+    static constexpr int g_divisor_shift { 2 };
+
+
+    //----------- Helper Functions
+
+    // Counts local 0 down to 0, running the body between decrements, in 5 instructions per iteration.
+    static std::vector<int> build_loop(const Loop_Program& program, int& starting_point) {
+        std::vector<int> code { program.functions };
+        starting_point = static_cast<int>(code.size());
+
+        code.insert(code.end(), program.setup.begin(), program.setup.end());
+        code.insert(code.end(), { Instruction::push, g_loop_iterations, Instruction::lstore, g_counter_local });
+
+        const int loop_start { static_cast<int>(code.size()) };
+
+        if (program.body) {
+            for (int i {}; i < g_body_repeats; ++i) {
+                program.body(code);
+            }
+        }
+
+        code.insert(code.end(), {
+            Instruction::lpush, g_counter_local,
+            Instruction::dec,
+            Instruction::dup,
+            Instruction::lstore, g_counter_local,
+            Instruction::brt, loop_start,
+            Instruction::exit
+        });
+
+        return code;
+    }
+
+    // Output goes to a Null_Logger, so "PRINT" still formats every value but nothing is written anywhere.
+    static std::uint64_t run_code(const std::vector<int>& code, int starting_point, Execution_Stats* stats = nullptr) {
+        Virtual_Machine vm { std::vector<int> { code }, starting_point, new Null_Logger() };
+        vm.set_trace_mode(false);
+        vm.set_execution_stats(stats);
+
+        if (vm.interpret() != Application::Status::success) {
+            throw std::runtime_error("Benchmark program did not run to completion.");
+        }
+
+        return vm.get_instructions_retired();
+    }
+
+    static void run_loop(Harness& harness, std::string_view name, const Loop_Program& program) {
+        int starting_point {};
+        const std::vector<int> code { build_loop(program, starting_point) };
+
+        harness.run(name, "instruction", [&code, starting_point]() {
+            return run_code(code, starting_point);
+        });
+    }
+
+    static Body_Writer repeat(std::vector<int> instructions) {
+        return [instructions](std::vector<int>& code) {
+            code.insert(code.end(), instructions.begin(), instructions.end());
+        };
+    }
+
+    // Branches to the instruction right after it, so the body goes the same way whether or not it is taken.
+    static Body_Writer branch_to_next(std::vector<int> before, int op_code) {
+        return [before, op_code](std::vector<int>& code) {
+            code.insert(code.end(), before.begin(), before.end());
+            code.push_back(op_code);
+            code.push_back(static_cast<int>(code.size()) + 1);
+        };
+    }
+
+
+    //----------- Benchmarks
+
+    void run_instruction_benchmarks(Harness& harness) {
+        run_loop(harness, "loop overhead", {});
+
+        // Binary operations, each paired with the "PUSH" of its second operand.
+        run_loop(harness, "PUSH + ADD", { {}, { Instruction::push, 0 }, repeat({ Instruction::push, 1, Instruction::add }) });
+        run_loop(harness, "PUSH + SUB", { {}, { Instruction::push, 0 }, repeat({ Instruction::push, 1, Instruction::sub }) });
+        run_loop(harness, "PUSH + MUL", { {}, { Instruction::push, 3 }, repeat({ Instruction::push, 1, Instruction::mul }) });
+        run_loop(harness, "PUSH + DIV", { {}, { Instruction::push, 1'000'000 }, repeat({ Instruction::push, 3, Instruction::div }) });
+        run_loop(harness, "PUSH + MOD", { {}, { Instruction::push, 1'000'000 }, repeat({ Instruction::push, 3, Instruction::mod }) });
+        run_loop(harness, "PUSH + LT", { {}, { Instruction::push, 5 }, repeat({ Instruction::push, 3, Instruction::lt }) });
+        run_loop(harness, "PUSH + GT", { {}, { Instruction::push, 5 }, repeat({ Instruction::push, 3, Instruction::gt }) });
+        run_loop(harness, "PUSH + EQ", { {}, { Instruction::push, 5 }, repeat({ Instruction::push, 3, Instruction::eq }) });
+        run_loop(harness, "PUSH + LEQ", { {}, { Instruction::push, 5 }, repeat({ Instruction::push, 3, Instruction::leq }) });
+        run_loop(harness, "PUSH + GEQ", { {}, { Instruction::push, 5 }, repeat({ Instruction::push, 3, Instruction::geq }) });
+        run_loop(harness, "PUSH + NEQ", { {}, { Instruction::push, 5 }, repeat({ Instruction::push, 3, Instruction::neq }) });
+
+        // Instructions that keep the stack as it is can run back to back.
+        run_loop(harness, "INC", { {}, { Instruction::push, 0 }, repeat({ Instruction::inc }) });
+        run_loop(harness, "DEC", { {}, { Instruction::push, 0 }, repeat({ Instruction::dec }) });
+        run_loop(harness, "NEG", { {}, { Instruction::push, 5 }, repeat({ Instruction::neg }) });
+        run_loop(harness, "SWAP", { {}, { Instruction::push, 1, Instruction::push, 2 }, repeat({ Instruction::swap }) });
+        run_loop(harness, "TURN", { {}, { Instruction::push, 1, Instruction::push, 2, Instruction::push, 3 }, repeat({ Instruction::turn }) });
+        run_loop(harness, "SHL", { {}, { Instruction::push, 5 }, repeat({ Instruction::shl, 0 }) });
+        run_loop(harness, "DIVP2", { {}, { Instruction::push, 1'000'000 }, repeat({ Instruction::divp2, 1 }) });
+        run_loop(harness, "MODP2", { {}, { Instruction::push, 1'000'000 }, repeat({ Instruction::modp2, 3 }) });
+        run_loop(harness, "DIVM", { {}, { Instruction::push, 1'000'000 }, repeat({ Instruction::divm, g_divisor, g_divisor_magic, g_divisor_shift }) });
+        run_loop(harness, "MODM", { {}, { Instruction::push, 1'000'000 }, repeat({ Instruction::modm, g_divisor, g_divisor_magic, g_divisor_shift }) });
+
+        // Instructions that push, each paired with whatever takes the value back off.
+        run_loop(harness, "PUSH + POP", { {}, {}, repeat({ Instruction::push, 1, Instruction::pop }) });
+        run_loop(harness, "DUP + POP", { {}, { Instruction::push, 1 }, repeat({ Instruction::dup, Instruction::pop }) });
+        run_loop(harness, "DUP2 + POP + POP", { {}, { Instruction::push, 1, Instruction::push, 2 }, repeat({ Instruction::dup2, Instruction::pop, Instruction::pop }) });
+        run_loop(harness, "OVER + POP", { {}, { Instruction::push, 1, Instruction::push, 2 }, repeat({ Instruction::over, Instruction::pop }) });
+        run_loop(harness, "LPUSH + LSTORE", { {}, {}, repeat({ Instruction::lpush, 1, Instruction::lstore, 1 }) });
+        run_loop(harness, "GPUSH + GSTORE", { {}, {}, repeat({ Instruction::gpush, 0, Instruction::gstore, 0 }) });
+    }
+
+    void run_control_flow_benchmarks(Harness& harness) {
+        run_loop(harness, "BR", { {}, {}, branch_to_next({}, Instruction::br) });
+        run_loop(harness, "PUSH + BRT (taken)", { {}, {}, branch_to_next({ Instruction::push, 1 }, Instruction::brt) });
+        run_loop(harness, "PUSH + BRT (not taken)", { {}, {}, branch_to_next({ Instruction::push, 0 }, Instruction::brt) });
+        run_loop(harness, "PUSH + BRF (taken)", { {}, {}, branch_to_next({ Instruction::push, 0 }, Instruction::brf) });
+        run_loop(harness, "PUSH + BRF (not taken)", { {}, {}, branch_to_next({ Instruction::push, 1 }, Instruction::brf) });
+
+        // Function 0 returns straight away. Function 1 hands over to function 0 through "TCALL."
+        const std::vector<int> functions { Instruction::ret, Instruction::tcall, 0, 0 };
+        run_loop(harness, "CALL + RET", { functions, {}, repeat({ Instruction::call, 0, 0 }) });
+        run_loop(harness, "PUSH + CALL + RET (1 argument)", { functions, {}, repeat({ Instruction::push, 1, Instruction::call, 0, 1 }) });
+        run_loop(harness, "CALL + TCALL + RET", { functions, {}, repeat({ Instruction::call, 1, 0 }) });
+
+        run_loop(harness, "DUP + PRINT (null sink)", { {}, { Instruction::push, -1'234'567 }, repeat({ Instruction::dup, Instruction::print }) });
+    }
+
+    void run_dispatch_benchmarks(Harness& harness) {
+        int starting_point {};
+        const std::vector<int> code { build_loop({ {}, { Instruction::push, 0 }, repeat({ Instruction::inc }) }, starting_point) };
+
+        harness.run("INC (no instrumentation)", "instruction", [&code, starting_point]() {
+            return run_code(code, starting_point);
+        });
+
+        harness.run("INC (counting --stats)", "instruction", [&code, starting_point]() {
+            Execution_Stats stats {};
+            return run_code(code, starting_point, &stats);
+        });
+    }
+}
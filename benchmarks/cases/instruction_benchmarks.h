@@ -0,0 +1,12 @@
+#pragma once
+
+#include "harness.h"
+
+namespace bench {
+    // Every instruction that can run on its own, each repeated in a tight generated loop.
+    void run_instruction_benchmarks(Harness& harness);
+    // Calls and returns, branches, and "PRINT" into a sink that discards its output.
+    void run_control_flow_benchmarks(Harness& harness);
+    // The same loop with and without instrumentation, to price the interpreting loop's instrumentation check.
+    void run_dispatch_benchmarks(Harness& harness);
+}
@@ -0,0 +1,99 @@
+#include "pch.h"
+#include "parser_benchmarks.h"
+#include "source_generator.h"
+#include "virtual_machine/parser.h"
+#include "common/allocation_counter.h"
+#include "common/resident_memory.h"
+
+#include <array>
+#include <filesystem>
+
+namespace bench {
+    using namespace svim;
+
+    //----------- Internal Types
+
+    struct Source_Size final {
+        std::string_view label {};
+        std::uint64_t bytes {};
+    };
+
+
+    //----------- Internal Data
+
+    static constexpr std::array<Source_Size, 6> g_source_sizes { {
+        { "1 KB", std::uint64_t { 1 } << 10 },
+        { "16 KB", std::uint64_t { 16 } << 10 },
+        { "256 KB", std::uint64_t { 256 } << 10 },
+        { "4 MB", std::uint64_t { 4 } << 20 },
+        { "64 MB", std::uint64_t { 64 } << 20 },
+        { "1 GB", std::uint64_t { 1 } << 30 }
+    } };
+
+    // Sources this large take long enough to time that a few runs are enough.
+    static constexpr std::uint64_t g_large_source_bytes { std::uint64_t { 4 } << 20 };
+    static constexpr int g_large_source_runs { 3 };
+
+    static constexpr std::uint32_t g_source_seed { 1 };
+
+
+    //----------- Benchmarks
+
+    void run_parser_benchmarks(Harness& harness, std::uint64_t largest_source_bytes) {
+        for (const Source_Size& size : g_source_sizes) {
+            const std::string name { "parse " + std::string(size.label) };
+
+            if ((size.bytes > largest_source_bytes) || !harness.is_selected(name)) {
+                continue;
+            }
+
+            // Parser only reads files, named without directories, from the working directory.
+            // Written right before parsing, the file is read back from the page cache, so the disk is left out of the timings.
+            const std::filesystem::path path { "parser_benchmark_" + std::to_string(size.bytes) + ".svim" };
+
+            std::uint64_t instructions {};
+
+            {
+                std::ofstream source { path, std::ios::binary };
+
+                if (!source.is_open()) {
+                    throw std::runtime_error("Could not write generated source file \"" + path.string() + ".\"");
+                }
+
+                Source_Generator generator { g_source_seed };
+                instructions = generator.write(source, size.bytes);
+            }
+
+            const std::uint64_t source_bytes { std::filesystem::file_size(path) };
+            Allocation_Counts allocated {};
+
+            const bool ran {
+                harness.run(name, "byte", [&path, source_bytes, &allocated]() {
+                    const Allocation_Counts start { get_allocation_counts() };
+                    Parser parser { path.string() };
+                    const std::vector<int> bytecode { parser.parse() };
+
+                    if (parser.get_status() != Parser::Status::success) {
+                        throw std::runtime_error("Generated source failed to parse.");
+                    }
+
+                    allocated = get_allocation_counts() - start;
+                    return source_bytes;
+                }, (size.bytes >= g_large_source_bytes) ? g_large_source_runs : std::numeric_limits<int>::max())
+            };
+
+            std::filesystem::remove(path);
+
+            if (!ran) {
+                continue;
+            }
+
+            const double seconds { static_cast<double>(harness.get_last_result().median) / 1e9 };
+
+            harness.add_metric("megabytes_per_second", static_cast<double>(source_bytes) / 1e6 / seconds);
+            harness.add_metric("instructions_per_second", static_cast<double>(instructions) / seconds);
+            harness.add_metric("allocated_megabytes", static_cast<double>(allocated.bytes) / 1e6);
+            harness.add_metric("peak_resident_megabytes", static_cast<double>(get_peak_resident_bytes()) / 1e6);
+        }
+    }
+}
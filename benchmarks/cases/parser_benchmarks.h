@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include "harness.h"
+
+namespace bench {
+    // Parses generated programs from 1 KB up to [largest_source_bytes], growing 16 times each step.
+    void run_parser_benchmarks(Harness& harness, std::uint64_t largest_source_bytes);
+}
@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "workload_benchmarks.h"
+#include "virtual_machine/virtual_machine.h"
+#include "virtual_machine/parser.h"
+#include "virtual_machine/optimizer.h"
+#include "interpreter/application.h"
+
+namespace bench {
+    using namespace svim;
+
+    //----------- Internal Types
+
+    struct Workload final {
+        std::string file {};
+        std::uint64_t output_bytes {};
+        std::uint64_t checksum {};
+    };
+
+    struct Output_Checksum final {
+        std::uint64_t bytes {};
+        // 64-bit FNV-1a, starting from its offset basis.
+        std::uint64_t hash { 14'695'981'039'346'656'037ULL };
+    };
+
+    // Hashes output instead of writing it anywhere.
+    class Checksum_Writer final : public Output_Writer {
+    public:
+        explicit Checksum_Writer(Output_Checksum& checksum) noexcept : m_checksum { checksum } {}
+
+        void write(const char* data, std::size_t size) override {
+            std::uint64_t hash { m_checksum.hash };
+
+            for (std::size_t i {}; i < size; ++i) {
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * 1'099'511'628'211ULL;
+            }
+
+            m_checksum.hash = hash;
+            m_checksum.bytes += size;
+        }
+
+    private:
+        Output_Checksum& m_checksum;
+    };
+
+    // Owned by the Virtual_Machine it is given to, so [checksum] is only complete once that machine is gone.
+    class Checksum_Logger final : public Logger {
+    public:
+        explicit Checksum_Logger(Output_Checksum& checksum) : Logger { std::make_unique<Checksum_Writer>(checksum) } {}
+    };
+
+    // Parser only reads files from the working directory, so workloads are run from inside theirs.
+    class Working_Directory final {
+    public:
+        explicit Working_Directory(const std::filesystem::path& directory) : m_previous { std::filesystem::current_path() } {
+            std::filesystem::current_path(directory);
+        }
+
+        ~Working_Directory() {
+            std::error_code ignored {};
+            std::filesystem::current_path(m_previous, ignored);
+        }
+
+        Working_Directory(const Working_Directory& other) = delete;
+        Working_Directory& operator =(const Working_Directory& other) = delete;
+
+    private:
+        std::filesystem::path m_previous {};
+    };
+
+
+    //----------- Internal Data
+
+    static constexpr std::string_view g_manifest_file { "expected_output.txt" };
+
+    // Workloads run for up to seconds each, so a few runs are enough.
+    static constexpr int g_workload_runs { 3 };
+
+
+    //----------- Helper Functions
+
+    // Reads "file bytes checksum" lines, skipping blank lines and those starting with '#.'
+    static std::vector<Workload> load_workloads(std::string_view manifest_file) {
+        std::ifstream input { std::string(manifest_file) };
+
+        if (!input.is_open()) {
+            throw std::runtime_error("Could not open workload list \"" + std::string(manifest_file) + ".\"");
+        }
+
+        std::vector<Workload> workloads {};
+        std::string line {};
+
+        while (std::getline(input, line)) {
+            if (line.empty() || (line[0] == '#')) {
+                continue;
+            }
+
+            std::istringstream fields { line };
+            Workload workload {};
+
+            if (!(fields >> workload.file >> workload.output_bytes >> std::hex >> workload.checksum)) {
+                throw std::runtime_error("Workload list line \"" + line + "\" is not \"file bytes checksum.\"");
+            }
+
+            workloads.push_back(std::move(workload));
+        }
+
+        return workloads;
+    }
+
+    static std::uint64_t run_workload(const Workload& workload, const std::vector<int>& code, int starting_point, std::string_view variant) {
+        Output_Checksum checksum {};
+        std::uint64_t instructions {};
+
+        {
+            Virtual_Machine vm { std::vector<int> { code }, starting_point, new Checksum_Logger(checksum) };
+
+            if (vm.interpret() != Application::Status::success) {
+                throw std::runtime_error("Workload \"" + workload.file + "\" (" + std::string(variant) + ") did not run to completion.");
+            }
+
+            instructions = vm.get_instructions_retired();
+        }
+
+        if ((checksum.bytes != workload.output_bytes) || (checksum.hash != workload.checksum)) {
+            std::ostringstream message {};
+            message
+                << "Workload \"" << workload.file << "\" (" << variant << ") printed " << checksum.bytes
+                << " bytes hashing to " << std::hex << checksum.hash << " rather than the " << std::dec << workload.output_bytes
+                << " bytes hashing to " << std::hex << workload.checksum << " it is expected to.";
+            throw std::runtime_error(message.str());
+        }
+
+        return instructions;
+    }
+
+    static void run_variant(Harness& harness, const Workload& workload, const std::vector<int>& code, int starting_point, std::string_view variant) {
+        std::string name { "workload " + workload.file.substr(0, workload.file.rfind('.')) };
+
+        if (variant != "optimized") {
+            name += " (" + std::string(variant) + ')';
+        }
+
+        const bool ran {
+            harness.run(name, "instruction", [&workload, &code, starting_point, variant]() {
+                return run_workload(workload, code, starting_point, variant);
+            }, g_workload_runs)
+        };
+
+        if (!ran) {
+            return;
+        }
+
+        const Result& result { harness.get_last_result() };
+        const double seconds { static_cast<double>(result.median) / 1e9 };
+
+        harness.add_metric("median_milliseconds", static_cast<double>(result.median) / 1e6);
+        harness.add_metric("instructions_per_second", static_cast<double>(result.operations) / seconds);
+    }
+
+
+    //----------- Benchmarks
+
+    void run_workload_benchmarks(Harness& harness, const std::filesystem::path& directory) {
+        if (!std::filesystem::is_directory(directory)) {
+            std::cerr << "Workload directory \"" << directory.string() << "\" not found. Skipping workload benchmarks.\n";
+            return;
+        }
+
+        const Working_Directory working_directory { directory };
+
+        for (const Workload& workload : load_workloads(g_manifest_file)) {
+            Parser parser { workload.file };
+            const std::vector<int> code { parser.parse() };
+
+            if (parser.get_status() != Parser::Status::success) {
+                throw std::runtime_error("Workload \"" + workload.file + "\" failed to parse.");
+            }
+
+            const int starting_point { parser.get_program_start_index() };
+
+            Optimizer optimizer { std::vector<int> { code }, starting_point, Optimizer::Settings {} };
+            const std::vector<int> optimized_code { optimizer.optimize() };
+
+            run_variant(harness, workload, optimized_code, optimizer.get_program_start_index(), "optimized");
+            run_variant(harness, workload, code, starting_point, "unoptimized");
+        }
+    }
+}
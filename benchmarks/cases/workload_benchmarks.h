@@ -0,0 +1,11 @@
+#pragma once
+
+#include <filesystem>
+#include "harness.h"
+
+namespace bench {
+    // Runs every workload listed in [directory]'s "expected_output.txt," both optimized and as parsed,
+    //     checking the output of every run against the length and checksum listed for it.
+    // Throws if any run's output differs. Skipped with a warning if [directory] does not exist.
+    void run_workload_benchmarks(Harness& harness, const std::filesystem::path& directory);
+}
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "harness.h"
+#include "common/timer.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace bench {
+    using namespace svim;
+
+    //----------- Helper Functions
+
+    // Nearest-rank percentile of sorted [times].
+    static std::int64_t get_percentile(const std::vector<std::int64_t>& times, int percent) {
+        const std::size_t rank { (times.size() * static_cast<std::size_t>(percent) + 99) / 100 };
+        return times[std::max<std::size_t>(rank, 1) - 1];
+    }
+
+
+    //----------- Result
+
+    double Result::get_per_operation(std::int64_t nanoseconds) const {
+        return (operations > 0) ? (static_cast<double>(nanoseconds) / static_cast<double>(operations)) : 0.0;
+    }
+
+
+    //----------- Harness
+
+    Harness::Harness(const Settings& settings, std::ostream& output) :
+        m_settings { settings },
+        m_output { output }
+    {
+        m_settings.warmup_runs = std::max(m_settings.warmup_runs, 0);
+        m_settings.measured_runs = std::max(m_settings.measured_runs, 1);
+    }
+
+    bool Harness::is_selected(std::string_view name) const {
+        return m_settings.filter.empty() || (name.find(m_settings.filter) != std::string_view::npos);
+    }
+
+    bool Harness::run(std::string_view name, std::string_view unit, const std::function<std::uint64_t()>& body, int maximum_runs) {
+        if (!is_selected(name)) {
+            return false;
+        }
+
+        const bool is_limited { maximum_runs < m_settings.measured_runs };
+        const int measured_runs { is_limited ? std::max(maximum_runs, 1) : m_settings.measured_runs };
+        const int warmup_runs { is_limited ? std::min(m_settings.warmup_runs, measured_runs / 2) : m_settings.warmup_runs };
+
+        for (int i {}; i < warmup_runs; ++i) {
+            body();
+        }
+
+        std::vector<std::int64_t> times {};
+        times.reserve(static_cast<std::size_t>(measured_runs));
+        std::uint64_t operations {};
+
+        for (int i {}; i < measured_runs; ++i) {
+            const Time_Point start { get_current_time() };
+            operations = body();
+            times.push_back(get_elapsed_nanoseconds(start, get_current_time()));
+        }
+
+        std::sort(times.begin(), times.end());
+
+        Result result { std::string(name), std::string(unit), operations, times.front(), get_percentile(times, 50), get_percentile(times, 95) };
+
+        if (m_settings.format == Format::text) {
+            print_text(result);
+        }
+
+        m_results.push_back(std::move(result));
+        return true;
+    }
+
+    void Harness::add_metric(std::string_view name, double value) {
+        m_results.back().metrics.emplace_back(std::string(name), value);
+
+        if (m_settings.format == Format::text) {
+            m_output << "    " << name << ": " << std::fixed << std::setprecision(3) << value << '\n' << std::flush;
+            m_output.unsetf(std::ios::floatfield);
+        }
+    }
+
+    void Harness::finish() {
+        if (m_settings.format == Format::json) {
+            print_json();
+        }
+    }
+
+    void Harness::print_text(const Result& result) {
+        if (!m_printed_header) {
+            m_output
+                << m_settings.measured_runs << " measured runs after " << m_settings.warmup_runs << " warmup runs. Costs are nanoseconds per unit.\n"
+                << std::left << std::setw(44) << "Benchmark" << std::right
+                << std::setw(12) << "Median" << std::setw(12) << "95th" << std::setw(12) << "Fastest"
+                << std::setw(14) << "Units/run" << "  Unit\n";
+            m_printed_header = true;
+        }
+
+        m_output
+            << std::left << std::setw(44) << result.name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << result.get_per_operation(result.median)
+            << std::setw(12) << result.get_per_operation(result.p95)
+            << std::setw(12) << result.get_per_operation(result.minimum)
+            << std::setw(14) << result.operations << "  " << result.unit << '\n' << std::flush;
+
+        m_output.unsetf(std::ios::floatfield);
+    }
+
+    void Harness::print_json() const {
+        m_output
+            << "{\"warmup_runs\":" << m_settings.warmup_runs
+            << ",\"measured_runs\":" << m_settings.measured_runs
+            << ",\"benchmarks\":[";
+
+        for (std::size_t i {}; i < m_results.size(); ++i) {
+            const Result& result { m_results[i] };
+
+            m_output
+                << ((i > 0) ? ",\n" : "\n")
+                << "{\"name\":\"" << result.name << "\",\"unit\":\"" << result.unit << '"'
+                << ",\"operations\":" << result.operations
+                << ",\"min_ns\":" << result.minimum
+                << ",\"median_ns\":" << result.median
+                << ",\"p95_ns\":" << result.p95
+                << std::fixed << std::setprecision(3)
+                << ",\"median_ns_per_operation\":" << result.get_per_operation(result.median)
+                << ",\"p95_ns_per_operation\":" << result.get_per_operation(result.p95);
+
+            for (const auto& [metric, value] : result.metrics) {
+                m_output << ",\"" << metric << "\":" << value;
+            }
+
+            m_output << '}';
+
+            m_output.unsetf(std::ios::floatfield);
+        }
+
+        m_output << "\n]}\n";
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench {
+    enum class Format {
+        text,
+        json
+    };
+
+    struct Settings {
+        // Runs thrown away before measuring, to fill caches and settle the CPU's clock.
+        int warmup_runs { 3 };
+        int measured_runs { 21 };
+        // Only benchmarks whose names contain this run. Empty runs all of them.
+        std::string filter {};
+        Format format { Format::text };
+    };
+
+    struct Result {
+        std::string name {};
+        // What costs are counted per, such as "instruction."
+        std::string unit {};
+        // Done by every run.
+        std::uint64_t operations {};
+        // Nanoseconds per run.
+        std::int64_t minimum {};
+        std::int64_t median {};
+        std::int64_t p95 {};
+        // Figures worked out from the timings by the benchmark itself, such as throughput.
+        std::vector<std::pair<std::string, double>> metrics {};
+
+        double get_per_operation(std::int64_t nanoseconds) const;
+    };
+
+
+    // Times benchmarks with steady_clock over warmup and measured runs, reporting each one's cost per operation
+    //     at the fastest, median, and 95th percentile run.
+    // Text results are printed as each benchmark finishes; JSON results are printed together by finish().
+    class Harness final {
+    public:
+        Harness(const Settings& settings, std::ostream& output);
+
+        bool is_selected(std::string_view name) const;
+
+        // Times [body], which does one run and returns how many [unit]s of work it did.
+        // Benchmarks too slow to repeat as often as usual can lower [maximum_runs], which also caps their warmup
+        //     at half as many runs.
+        // Returns false, without running [body], if [name] is not selected.
+        bool run(
+            std::string_view name,
+            std::string_view unit,
+            const std::function<std::uint64_t()>& body,
+            int maximum_runs = std::numeric_limits<int>::max()
+            );
+        // Only valid after run() has returned true.
+        const Result& get_last_result() const { return m_results.back(); }
+        // Adds a figure to the last benchmark run, printed beneath it as text or added to its JSON object.
+        void add_metric(std::string_view name, double value);
+        void finish();
+
+        Harness(const Harness& other) = delete;
+        Harness& operator =(const Harness& other) = delete;
+
+    private:
+        Settings m_settings {};
+        std::ostream& m_output;
+        std::vector<Result> m_results {};
+        bool m_printed_header {};
+
+        void print_text(const Result& result);
+        void print_json() const;
+    };
+}
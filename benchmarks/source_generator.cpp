@@ -0,0 +1,279 @@
+#include "pch.h"
+#include "source_generator.h"
+#include "virtual_machine/instructions.h"
+
+#include <array>
+#include <cctype>
+
+namespace bench {
+    using namespace svim;
+
+    //----------- Internal Data
+
+    // Main code keeps to globals below this. Functions write to the ones above it.
+    static constexpr int g_shared_globals { 50 };
+    static constexpr int g_one_argument_result { 99 };
+    static constexpr int g_two_argument_result { 98 };
+    // Local 0 is left for counted loops.
+    static constexpr int g_loop_local { 0 };
+
+    static constexpr std::array<std::string_view, 3> g_arithmetic { g_add, g_sub, g_mul };
+    static constexpr std::array<std::string_view, 3> g_unary { g_inc, g_dec, g_negate };
+    static constexpr std::array<std::string_view, 6> g_comparisons {
+        g_less_than, g_greater_than, g_equals, g_less_than_or_equal, g_greater_than_or_equal, g_not_equal
+    };
+
+    static constexpr std::array<std::string_view, 6> g_comments {
+        "keep the running total",
+        "scratch value",
+        "checked again below",
+        "TODO: fold this into the loop",
+        "matches the old behavior",
+        "see header"
+    };
+
+    static constexpr std::array<std::string_view, 3> g_indents { "", "    ", "\t" };
+    static constexpr std::array<std::string_view, 3> g_separators { " ", "\t", "   " };
+
+
+    //----------- Source_Generator
+
+    Source_Generator::Source_Generator(std::uint32_t seed) : m_random { seed } {}
+
+    std::uint64_t Source_Generator::write(std::ostream& output, std::uint64_t target_bytes) {
+        m_output = &output;
+        m_line.clear();
+        m_bytes = 0;
+        m_instructions = 0;
+        m_address = 0;
+        m_functions.clear();
+
+        write_comment("Generated SVIM program for parser benchmarks.");
+
+        for (int count { pick(2, 6) }; count > 0; --count) {
+            write_function();
+            write_padding();
+        }
+
+        end_line();
+        m_line += g_indents[pick(0, 1)];
+        m_line += chance(80) ? ".INIT" : ".init";
+        end_line();
+
+        // Leaves room for the "EXIT" that ends the program.
+        while ((m_bytes + m_line.size() + 8) < target_bytes) {
+            write_statement();
+            write_padding();
+        }
+
+        write_instruction(g_exit);
+        end_line();
+        return m_instructions;
+    }
+
+    void Source_Generator::write_function() {
+        const Function function { m_address, pick(1, 2) };
+        m_functions.push_back(function);
+
+        end_line();
+        write_comment((function.argument_count == 1) ? "FUNCTION: scale (local in: int) (global out: int)" : "FUNCTION: sum (local in: int, int) (global out: int)");
+
+        if (function.argument_count == 1) {
+            write_instruction(g_local_push, 0);
+            write_instruction(g_push, pick(2, 10));
+            write_instruction(g_mul);
+            write_instruction(g_global_store, g_one_argument_result);
+        }
+        else {
+            write_instruction(g_local_push, 0);
+            write_instruction(g_local_push, 1);
+            write_instruction(g_add);
+            write_instruction(g_global_store, g_two_argument_result);
+        }
+
+        write_instruction(g_ret);
+    }
+
+    // Every statement leaves the stack as it found it, so they can follow each other in any order.
+    void Source_Generator::write_statement() {
+        const int global { pick(0, g_shared_globals - 1) };
+        const int local { pick(1, 9) };
+        const int kind { pick(0, 99) };
+
+        if (kind < 20) {
+            write_instruction(g_push, pick(-1000, 1000));
+            write_instruction(g_push, pick(-1000, 1000));
+            write_instruction(g_arithmetic[pick(0, g_arithmetic.size() - 1)]);
+            write_instruction(g_global_store, global);
+        }
+        else if (kind < 35) {
+            write_instruction(g_push, pick(-1000, 1000));
+            write_instruction(g_local_store, local);
+            write_instruction(g_local_push, local);
+            write_instruction(g_unary[pick(0, g_unary.size() - 1)]);
+            write_instruction(g_local_store, local);
+        }
+        else if (kind < 50) {
+            // Skips the increment below when the comparison fails.
+            write_instruction(g_global_push, global);
+            write_instruction(g_push, pick(-1000, 1000));
+            write_instruction(g_comparisons[pick(0, g_comparisons.size() - 1)]);
+            write_instruction(g_branch_if_false, m_address + 7);
+            write_instruction(g_global_push, global);
+            write_instruction(g_inc);
+            write_instruction(g_global_store, global);
+        }
+        else if (kind < 60) {
+            const Function& function { m_functions[pick(0, static_cast<int>(m_functions.size()) - 1)] };
+
+            for (int i {}; i < function.argument_count; ++i) {
+                if (chance(50)) {
+                    write_instruction(g_global_push, pick(0, g_shared_globals - 1));
+                }
+                else {
+                    write_instruction(g_push, pick(-1000, 1000));
+                }
+            }
+
+            write_instruction(g_call, function.address, function.argument_count);
+        }
+        else if (kind < 65) {
+            write_instruction(g_global_push, global);
+            write_instruction(g_print);
+        }
+        else if (kind < 75) {
+            write_instruction(g_push, pick(-1000, 1000));
+            write_instruction(g_push, pick(-1000, 1000));
+            write_instruction(g_swap);
+            write_instruction(g_sub);
+            write_instruction(g_duplicate);
+            write_instruction(g_mul);
+            write_instruction(g_pop);
+        }
+        else if (kind < 85) {
+            write_instruction(g_push, pick(1, 5));
+            write_instruction(g_local_store, g_loop_local);
+
+            const int loop_start { m_address };
+            write_instruction(g_local_push, g_loop_local);
+            write_instruction(g_dec);
+            write_instruction(g_duplicate);
+            write_instruction(g_local_store, g_loop_local);
+            write_instruction(g_branch_if_true, loop_start);
+        }
+        else {
+            write_instruction(g_global_push, global);
+            write_instruction(g_push, pick(1, 9));
+            write_instruction(chance(50) ? g_div : g_mod);
+            write_instruction(g_global_store, pick(0, g_shared_globals - 1));
+        }
+    }
+
+    void Source_Generator::write_padding() {
+        if (chance(8)) {
+            end_line();
+            m_output->put('\n');
+            ++m_bytes;
+        }
+        else if (chance(5)) {
+            end_line();
+            write_comment(g_comments[pick(0, g_comments.size() - 1)]);
+        }
+    }
+
+    void Source_Generator::write_instruction(std::string_view name) {
+        // Instructions without operands sometimes share a line, as in "ADD PRINT."
+        if (m_line.empty() || !chance(6)) {
+            end_line();
+            m_line += g_indents[pick(0, g_indents.size() - 1)];
+        }
+        else {
+            m_line += ' ';
+        }
+
+        write_name(name);
+        ++m_instructions;
+        ++m_address;
+
+        if (chance(10)) {
+            write_comment(g_comments[pick(0, g_comments.size() - 1)]);
+        }
+    }
+
+    void Source_Generator::write_instruction(std::string_view name, int operand) {
+        end_line();
+        m_line += g_indents[pick(0, g_indents.size() - 1)];
+        write_name(name);
+
+        if (chance(3)) {
+            end_line();
+        }
+        else {
+            m_line += g_separators[pick(0, g_separators.size() - 1)];
+        }
+
+        m_line += std::to_string(operand);
+        ++m_instructions;
+        m_address += 2;
+
+        if (chance(12)) {
+            write_comment(g_comments[pick(0, g_comments.size() - 1)]);
+        }
+    }
+
+    void Source_Generator::write_instruction(std::string_view name, int first_operand, int second_operand) {
+        end_line();
+        m_line += g_indents[pick(0, g_indents.size() - 1)];
+        write_name(name);
+        m_line += g_separators[pick(0, g_separators.size() - 1)];
+        m_line += std::to_string(first_operand);
+        m_line += ' ';
+        m_line += std::to_string(second_operand);
+        ++m_instructions;
+        m_address += 3;
+
+        if (chance(12)) {
+            write_comment(g_comments[pick(0, g_comments.size() - 1)]);
+        }
+    }
+
+    // Mostly upper case, as in hand-written code, with some lower and capitalized names.
+    void Source_Generator::write_name(std::string_view name) {
+        const int style { pick(0, 9) };
+
+        for (std::size_t i {}; i < name.size(); ++i) {
+            const bool lower { (style == 8) || ((style == 9) && (i > 0)) };
+            m_line += lower ? static_cast<char>(std::tolower(static_cast<unsigned char>(name[i]))) : name[i];
+        }
+    }
+
+    // Ends the line, so nothing follows a comment.
+    void Source_Generator::write_comment(std::string_view text) {
+        if (!m_line.empty()) {
+            m_line += g_separators[pick(0, g_separators.size() - 1)];
+        }
+
+        m_line += "# ";
+        m_line += text;
+        end_line();
+    }
+
+    void Source_Generator::end_line() {
+        if (m_line.empty()) {
+            return;
+        }
+
+        m_line += '\n';
+        m_output->write(m_line.data(), static_cast<std::streamsize>(m_line.size()));
+        m_bytes += m_line.size();
+        m_line.clear();
+    }
+
+    bool Source_Generator::chance(int percent) {
+        return pick(0, 99) < percent;
+    }
+
+    int Source_Generator::pick(int lowest, int highest) {
+        return std::uniform_int_distribution<int> { lowest, highest }(m_random);
+    }
+}
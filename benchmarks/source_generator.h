@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+    // Writes valid, runnable SVIM programs of any size, shaped like hand-written ones: functions ahead of ".INIT,"
+    //     a mix of arithmetic, locals, globals, forward branches, calls, and "PRINT," and the formatting the parser
+    //     has to tolerate, such as comments, blank lines, mixed case, tabs, and operands on the following line.
+    // The same seed always writes the same program.
+    class Source_Generator final {
+    public:
+        explicit Source_Generator(std::uint32_t seed);
+
+        // Writes a program of at least [target_bytes], returning how many instructions it holds.
+        std::uint64_t write(std::ostream& output, std::uint64_t target_bytes);
+
+        Source_Generator(const Source_Generator& other) = delete;
+        Source_Generator& operator =(const Source_Generator& other) = delete;
+
+    private:
+        struct Function {
+            int address {};
+            int argument_count {};
+        };
+
+        std::mt19937 m_random;
+        std::ostream* m_output {};
+        std::string m_line {};
+        std::uint64_t m_bytes {};
+        std::uint64_t m_instructions {};
+        // Bytecode index of the next instruction, for branch and call targets.
+        int m_address {};
+        std::vector<Function> m_functions {};
+
+        void write_function();
+        void write_statement();
+        void write_padding();
+        void write_instruction(std::string_view name);
+        void write_instruction(std::string_view name, int operand);
+        void write_instruction(std::string_view name, int first_operand, int second_operand);
+        void write_name(std::string_view name);
+        void write_comment(std::string_view text);
+        void end_line();
+
+        bool chance(int percent);
+        int pick(int lowest, int highest);
+    };
+}
@@ -87,6 +87,8 @@ workspace "svim"
         links "svim"
         libdirs "bin/virtual_machine/%{prj.cfg}"
         dependson "virtual_machine"
+        filter "system:linux"
+            links "pthread"
         filter "configurations:Debug"
             symbols "On"
             defines (SVIM_DEBUG)
@@ -117,6 +119,43 @@ workspace "svim"
             "tests/cases/",
             "tests/examples/"
         }
+        filter "system:linux"
+            links "pthread"
         filter "configurations:Debug"
             symbols "On"
             defines (SVIM_DEBUG)
+
+    project "benchmarks"
+        kind "ConsoleApp"
+        targetname "svim_benchmarks"
+        location ("build/%{prj.name}/" .. _ACTION)
+        targetdir "bin/%{prj.name}/%{cfg.buildcfg}/%{cfg.platform}"
+        objdir "obj/"
+        language "C++"
+        cppdialect "C++20"
+        files {
+            "src/**.h",
+            "src/**.cpp",
+            "benchmarks/**.h",
+            "benchmarks/**.cpp"
+        }
+        removefiles {
+            "src/interpreter/main.cpp",
+            "pch.cpp"
+        }
+        includedirs {
+            "src/",
+            "src/virtual_machine/",
+            "src/interpreter/",
+            "src/common/",
+            "benchmarks/",
+            "benchmarks/cases/"
+        }
+        filter "system:linux"
+            links "pthread"
+        filter "configurations:Debug"
+            symbols "On"
+            defines (SVIM_DEBUG)
+        -- Timings are only meaningful with optimizations on.
+        filter "configurations:Release"
+            optimize "Speed"
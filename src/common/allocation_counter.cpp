@@ -0,0 +1,98 @@
+#include "pch.h"
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replacing the global allocation functions counts every allocation in the program, including those made by
+//     the standard library. Only the plain and aligned forms need replacing; the array and non-throwing forms
+//     are defined by the standard to forward to them.
+
+namespace svim {
+    //----------- Internal Data
+
+    static std::atomic<std::uint64_t> g_allocations {};
+    static std::atomic<std::uint64_t> g_allocated_bytes {};
+
+
+    //----------- Helper Functions
+
+    static void count_allocation(std::size_t size) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void* allocate(std::size_t size) {
+        count_allocation(size);
+
+        // malloc(0) may give back nullptr, but "operator new" must not.
+        void* memory { std::malloc((size > 0) ? size : 1) };
+
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return memory;
+    }
+
+    static void* allocate_aligned(std::size_t size, std::size_t alignment) {
+        count_allocation(size);
+
+#if defined(_WIN32)
+        void* memory { _aligned_malloc((size > 0) ? size : 1, alignment) };
+#else
+        // aligned_alloc() wants a size that is a multiple of the alignment.
+        const std::size_t rounded_size { ((size + alignment - 1) / alignment) * alignment };
+        void* memory { std::aligned_alloc(alignment, (rounded_size > 0) ? rounded_size : alignment) };
+#endif
+
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return memory;
+    }
+
+    static void free_aligned(void* memory) {
+#if defined(_WIN32)
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+
+
+    //----------- Allocation Counting
+
+    Allocation_Counts get_allocation_counts() {
+        return { g_allocations.load(std::memory_order_relaxed), g_allocated_bytes.load(std::memory_order_relaxed) };
+    }
+}
+
+
+//----------- Global Allocation Functions
+
+void* operator new(std::size_t size) {
+    return svim::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return svim::allocate_aligned(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    svim::free_aligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    svim::free_aligned(memory);
+}
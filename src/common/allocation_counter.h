@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace svim {
+    // Totals since the program started, across every thread.
+    struct Allocation_Counts final {
+        std::uint64_t allocations {};
+        std::uint64_t bytes {};
+    };
+
+    // Counted by the replacements for the global "operator new" that come with this header.
+    // Subtract two readings to get what happened in between.
+    Allocation_Counts get_allocation_counts();
+
+    inline Allocation_Counts operator -(const Allocation_Counts& end, const Allocation_Counts& start) {
+        return { end.allocations - start.allocations, end.bytes - start.bytes };
+    }
+}
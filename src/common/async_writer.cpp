@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "async_writer.h"
+
+#include <algorithm>
+
+namespace svim {
+    //----------- Async_Writer
+
+    Async_Writer::Async_Writer(std::unique_ptr<Output_Writer>&& target) :
+        m_target { std::move(target) },
+        m_ring { std::make_unique<char[]>(s_ring_size) },
+        m_thread { &Async_Writer::drain, this } {}
+
+    Async_Writer::~Async_Writer() {
+        {
+            std::lock_guard<std::mutex> lock { m_wait_mutex };
+            m_stopping.store(true, std::memory_order_release);
+        }
+
+        m_data_ready.notify_one();
+        m_thread.join();
+    }
+
+    void Async_Writer::write(const char* data, std::size_t size) {
+        rethrow_failure();
+
+        while (size > 0) {
+            // Only this thread changes m_queued.
+            const std::size_t queued { m_queued.load(std::memory_order_relaxed) };
+            const std::size_t free_space { s_ring_size - (queued - m_written.load(std::memory_order_acquire)) };
+
+            if (free_space == 0) {
+                wait_for_written(queued - s_ring_size + 1);
+                rethrow_failure();
+                continue;
+            }
+
+            const std::size_t offset { queued % s_ring_size };
+            const std::size_t chunk { std::min({ size, free_space, s_ring_size - offset }) };
+
+            std::memcpy(m_ring.get() + offset, data, chunk);
+            m_queued.store(queued + chunk, std::memory_order_release);
+
+            data += chunk;
+            size -= chunk;
+
+            // Locking between publishing and notifying keeps the background thread from missing the wakeup.
+            { std::lock_guard<std::mutex> lock { m_wait_mutex }; }
+            m_data_ready.notify_one();
+        }
+    }
+
+    void Async_Writer::flush() {
+        rethrow_failure();
+        wait_for_written(m_queued.load(std::memory_order_relaxed));
+        rethrow_failure();
+
+        // The background thread is idle until more is queued, so the target is ours for now.
+        m_target->flush();
+    }
+
+    // Runs on the background thread.
+    void Async_Writer::drain() {
+        while (true) {
+            // Only this thread changes m_written.
+            const std::size_t written { m_written.load(std::memory_order_relaxed) };
+            const std::size_t queued { m_queued.load(std::memory_order_acquire) };
+
+            if (queued == written) {
+                std::unique_lock<std::mutex> lock { m_wait_mutex };
+
+                m_data_ready.wait(lock, [&]() {
+                    return m_stopping.load(std::memory_order_acquire) || (m_queued.load(std::memory_order_acquire) != written);
+                });
+
+                // Stopping only ends the thread once everything queued is out.
+                if (m_queued.load(std::memory_order_acquire) == written) {
+                    return;
+                }
+
+                continue;
+            }
+
+            const std::size_t offset { written % s_ring_size };
+            const std::size_t chunk { std::min(queued - written, s_ring_size - offset) };
+
+            try {
+                m_target->write(m_ring.get() + offset, chunk);
+                m_written.store(written + chunk, std::memory_order_release);
+            }
+            catch (...) {
+                m_failure = std::current_exception();
+                m_failed.store(true, std::memory_order_release);
+            }
+
+            { std::lock_guard<std::mutex> lock { m_wait_mutex }; }
+            m_space_ready.notify_all();
+
+            if (m_failed.load(std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    void Async_Writer::wait_for_written(std::size_t total) {
+        if (m_written.load(std::memory_order_acquire) >= total) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock { m_wait_mutex };
+
+        m_space_ready.wait(lock, [&]() {
+            return (m_written.load(std::memory_order_acquire) >= total) || m_failed.load(std::memory_order_acquire);
+        });
+    }
+
+    void Async_Writer::rethrow_failure() {
+        if (m_failed.load(std::memory_order_acquire)) {
+            std::rethrow_exception(m_failure);
+        }
+    }
+}
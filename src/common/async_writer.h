@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "output_sink.h"
+
+namespace svim {
+    // Hands output to a background thread through a lock-free single-producer/single-consumer ring,
+    //     so the interpreting thread never waits on disk. The background thread passes it on to [target]
+    //     in chunks as large as whatever has piled up.
+    // The producer only waits when the ring is full (backpressure) or on flush().
+    class Async_Writer final : public Output_Writer {
+    public:
+        explicit Async_Writer(std::unique_ptr<Output_Writer>&& target);
+        // Writes out everything still queued before stopping the background thread.
+        ~Async_Writer() override;
+
+        void write(const char* data, std::size_t size) override;
+        // Waits until the target has received everything written so far.
+        void flush() override;
+        std::size_t get_buffer_bytes() const override { return s_ring_size; }
+
+        Async_Writer(const Async_Writer& other) = delete;
+        Async_Writer& operator =(const Async_Writer& other) = delete;
+
+    private:
+        inline static constexpr std::size_t s_ring_size { 8 * 1024 * 1024 };
+
+        std::unique_ptr<Output_Writer> m_target {};
+        std::unique_ptr<char[]> m_ring {};
+
+        // Running totals of bytes queued and written out; their difference is what the ring holds.
+        std::atomic<std::size_t> m_queued {};
+        std::atomic<std::size_t> m_written {};
+        std::atomic<bool> m_stopping {};
+
+        // Only guard sleeping; neither side takes the lock to move data.
+        std::mutex m_wait_mutex {};
+        std::condition_variable m_data_ready {};
+        std::condition_variable m_space_ready {};
+
+        // Set by the background thread if the target fails, then rethrown on the producer's next call.
+        std::exception_ptr m_failure {};
+        std::atomic<bool> m_failed {};
+
+        std::thread m_thread {};
+
+        void drain();
+        void wait_for_written(std::size_t total);
+        void rethrow_failure();
+    };
+}
@@ -0,0 +1,177 @@
+#include "pch.h"
+#include "hardware_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace svim {
+    //----------- Internal Data
+
+    static constexpr std::array<std::string_view, Hardware_Counters::s_counter_count> g_counter_names { {
+        "cycles",
+        "instructions",
+        "branch-misses",
+        "L1i-misses",
+        "L1d-misses",
+        "iTLB-misses"
+    } };
+
+
+    //----------- Helper Functions
+
+#if defined(__linux__)
+    // Cache events pack their cache, operation, and result into one config value.
+    static constexpr std::uint64_t get_cache_config(std::uint64_t cache, std::uint64_t operation, std::uint64_t result) {
+        return cache | (operation << 8) | (result << 16);
+    }
+
+    static perf_event_attr get_counter_attributes(Hardware_Counters::Counter counter) {
+        perf_event_attr attributes {};
+        attributes.size = sizeof(attributes);
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        switch (counter) {
+        case Hardware_Counters::Counter::cycles:
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+
+        case Hardware_Counters::Counter::instructions:
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+
+        case Hardware_Counters::Counter::branch_misses:
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+
+        case Hardware_Counters::Counter::l1i_misses:
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = get_cache_config(PERF_COUNT_HW_CACHE_L1I, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+
+        case Hardware_Counters::Counter::l1d_misses:
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = get_cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+
+        case Hardware_Counters::Counter::itlb_misses:
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = get_cache_config(PERF_COUNT_HW_CACHE_ITLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        }
+
+        return attributes;
+    }
+
+    static int open_counter(Hardware_Counters::Counter counter) {
+        perf_event_attr attributes { get_counter_attributes(counter) };
+
+        // This thread only, on whichever CPU it runs.
+        const long descriptor { ::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0) };
+        return static_cast<int>(descriptor);
+    }
+#endif
+
+
+    //----------- Hardware_Counters
+
+#if defined(__linux__)
+    Hardware_Counters::Hardware_Counters() {
+        for (std::size_t i {}; i < s_counter_count; ++i) {
+            const int descriptor { open_counter(static_cast<Counter>(i)) };
+            m_descriptors[i] = (descriptor >= 0) ? descriptor : s_unavailable;
+        }
+    }
+
+    Hardware_Counters::~Hardware_Counters() {
+        for (int descriptor : m_descriptors) {
+            if (descriptor != s_unavailable) {
+                ::close(descriptor);
+            }
+        }
+    }
+
+    void Hardware_Counters::start() {
+        for (int descriptor : m_descriptors) {
+            if (descriptor != s_unavailable) {
+                ::ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    void Hardware_Counters::stop() {
+        for (int descriptor : m_descriptors) {
+            if (descriptor != s_unavailable) {
+                ::ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+
+    std::uint64_t Hardware_Counters::read(Counter counter) const {
+        const int descriptor { m_descriptors[static_cast<std::size_t>(counter)] };
+
+        if (descriptor == s_unavailable) {
+            return 0;
+        }
+
+        // Laid out as requested by "read_format."
+        struct {
+            std::uint64_t value {};
+            std::uint64_t time_enabled {};
+            std::uint64_t time_running {};
+        } reading {};
+
+        if ((::read(descriptor, &reading, sizeof(reading)) != sizeof(reading)) || (reading.time_running == 0)) {
+            return 0;
+        }
+
+        if (reading.time_running == reading.time_enabled) {
+            return reading.value;
+        }
+
+        return static_cast<std::uint64_t>(static_cast<double>(reading.value) * static_cast<double>(reading.time_enabled) / static_cast<double>(reading.time_running));
+    }
+#else
+    Hardware_Counters::Hardware_Counters() {
+        m_descriptors.fill(s_unavailable);
+    }
+
+    Hardware_Counters::~Hardware_Counters() = default;
+
+    void Hardware_Counters::start() {}
+
+    void Hardware_Counters::stop() {}
+
+    std::uint64_t Hardware_Counters::read(Counter counter) const {
+        return 0;
+    }
+#endif
+
+    bool Hardware_Counters::is_available() const {
+        for (int descriptor : m_descriptors) {
+            if (descriptor != s_unavailable) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool Hardware_Counters::is_available(Counter counter) const {
+        return m_descriptors[static_cast<std::size_t>(counter)] != s_unavailable;
+    }
+
+    std::string_view Hardware_Counters::get_name(Counter counter) {
+        return g_counter_names[static_cast<std::size_t>(counter)];
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace svim {
+    // CPU performance counters for the current thread, read through Linux's perf_event_open.
+    // Every counter is opened on its own, so any the kernel, CPU, or container refuses are simply left out;
+    //     elsewhere than Linux, none are available.
+    class Hardware_Counters final {
+    public:
+        enum class Counter {
+            cycles,
+            instructions,
+            branch_misses,
+            l1i_misses,
+            l1d_misses,
+            itlb_misses
+        };
+
+        inline static constexpr std::size_t s_counter_count { 6 };
+
+        Hardware_Counters();
+        ~Hardware_Counters();
+
+        bool is_available() const;
+        bool is_available(Counter counter) const;
+        static std::string_view get_name(Counter counter);
+
+        // Zeroes and starts every available counter.
+        void start();
+        void stop();
+        // Gives 0 for unavailable counters. Counts are scaled up if the kernel had to time-share the counter.
+        std::uint64_t read(Counter counter) const;
+
+        Hardware_Counters(const Hardware_Counters& other) = delete;
+        Hardware_Counters& operator =(const Hardware_Counters& other) = delete;
+
+    private:
+        inline static constexpr int s_unavailable { -1 };
+
+        std::array<int, s_counter_count> m_descriptors {};
+    };
+}
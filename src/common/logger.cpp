@@ -1,7 +1,10 @@
 #include "pch.h"
 #include "logger.h"
-#include "error.h"
+#include "async_writer.h"
+#include "mapped_file_writer.h"
 #include "virtual_machine/instructions.h"
+#include "virtual_machine/trace_buffer.h"
+#include "virtual_machine/line_table.h"
 
 namespace svim {
     //-------------------- Internal Data
@@ -20,62 +23,89 @@ namespace svim {
     static constexpr std::string_view g_locals_epilogue { "]\n\n" };
 
     static constexpr std::string_view g_code_header { "\n\tSource Code Values\n\t---------\n" };
+    static constexpr std::string_view g_lines_header { "\n\tSource Lines\n\t---------\n" };
 
 
     //-------------------- Helper Functions
 
-    static int peek_next(int instruction_index, const int* bytecode_start) { return *(bytecode_start + instruction_index + 1); }
-    static int peek_over(int instruction_index, const int* bytecode_start) { return *(bytecode_start + instruction_index + 2); }
+    // [operands] points at the values following the instruction in the bytecode.
+    static void log_instruction_header(std::ostream& output, int instruction_index, int op_code, const int* operands, Source_Location location) {
+        const Instruction_Data& instruction { g_instruction_data[op_code] };
+
+        output
+            << "Instruction "
+            << instruction.name
+            << " (" << op_code << "): Index "
+            << instruction_index << ln;
+
+        if (location.is_known()) {
+            output << g_space << "Line " << location.line << ", column " << location.column << ln;
+        }
+
+        if (instruction.expected_following_values > 0) {
+            output << g_space << "Next: ";
 
+            for (int i {}; i < instruction.expected_following_values; ++i) {
+                if (i > 0) {
+                    output << ',';
+                }
+
+                output << operands[i];
+            }
+
+            output << ln;
+        }
+    }
+
+    // [first_index] is the index of data[0] in the full array; any values before it are elided.
     static void log_array(std::ostream& output, std::string_view prologue,
-                          const int* data, const std::size_t count, std::string_view epilogue) {
+                          const int* data, const std::size_t count, std::string_view epilogue,
+                          std::size_t first_index = 0) {
         output << g_space << prologue;
 
+        if (first_index > 0) {
+            output << "...";
+        }
+
         for (int i {}; i < count; ++i) {
-            if ((i > 0) && (i < count)) {
+            if ((i > 0) || (first_index > 0)) {
                 output << ',';
             }
 
-            output << i << '=' << data[i];
+            output << (first_index + i) << '=' << data[i];
         }
 
         output << epilogue;
     }
 
+    static std::unique_ptr<Output_Writer> open_file_writer(std::string_view out_file, File_Output_Mode mode) {
+        switch (mode) {
+        case File_Output_Mode::asynchronous:
+            return std::make_unique<Async_Writer>(Descriptor_Writer::open_file(out_file));
+
+        case File_Output_Mode::mapped:
+            return Mapped_File_Writer::open_file(out_file);
+
+        default:
+            return Descriptor_Writer::open_file(out_file);
+        }
+    }
+
 
     //-------------------- Logger
 
+    Logger::Logger(std::unique_ptr<Output_Writer>&& writer) : m_sink { std::move(writer) } {}
+
     void Logger::log_value(int value) {
-        get_output() << value << ln;
+        m_sink.write_value(value);
     }
 
-    void Logger::log_instruction(int instruction_index, const std::vector<int>& bytecode, int op_code) {
+    void Logger::log_instruction(int instruction_index, const std::vector<int>& bytecode, int op_code, Source_Location location) {
         if (op_code >= g_instruction_data.size()) {
             return;
         }
 
-        const Instruction_Data& instruction { g_instruction_data[op_code] };
-
-        get_output()
-            << "Instruction "
-            << instruction.name
-            << " (" << op_code << "): Index "
-            << instruction_index << ln;
-
-        if (instruction.expected_following_values == 1) {
-            get_output()
-                << g_space
-                << "Next: "
-                << peek_next(instruction_index, bytecode.data()) << ln;
-        }
-        else if (instruction.expected_following_values == 2) {
-            get_output()
-                << g_space
-                << "Next: "
-                << peek_next(instruction_index, bytecode.data())
-                << ','
-                << peek_over(instruction_index, bytecode.data()) << ln;
-        }
+        log_instruction_header(get_output(), instruction_index, op_code, bytecode.data() + instruction_index + 1, location);
     }
 
     void Logger::log_global_data(const std::vector<int>& global_data) {
@@ -102,31 +132,53 @@ namespace svim {
         get_output() << ln;
     }
 
+    void Logger::log_line_table(const Line_Table& lines) {
+        get_output() << g_lines_header;
+
+        for (const Line_Table::Row& row : lines.get_rows()) {
+            get_output() << '\t' << row.address << ": Line " << row.location.line << ", column " << row.location.column << ln;
+        }
+
+        get_output() << ln;
+    }
+
     void Logger::output_invalid_op_code(int bad_op_code) {
         get_output() << "Invalid operation code \"" << bad_op_code << '\"' << ln;
     }
 
+    void Logger::log_trace_event(const Trace_Event& event, Source_Location location) {
+        if ((event.op_code < 0) || (static_cast<std::size_t>(event.op_code) >= g_instruction_data.size())) {
+            output_invalid_op_code(event.op_code);
+            return;
+        }
+
+        log_instruction_header(get_output(), event.instruction_index, event.op_code, event.operands, location);
+
+        const std::size_t depth { static_cast<std::size_t>(event.stack_depth) };
+        const std::size_t shown { (depth < Trace_Event::s_stack_values) ? depth : Trace_Event::s_stack_values };
+        log_array(get_output(), g_stack_prologue, event.stack_top, shown, g_stack_epilogue, depth - shown);
+    }
+
+    void Logger::log_skipped_trace_events(std::uint64_t count) {
+        get_output() << "(" << count << " earlier instructions were not kept)" << ln << ln;
+    }
+
+    void Logger::log_tracepoint(int instruction_index, std::uint64_t hit_count) {
+        get_output() << "Tracepoint at index " << instruction_index << " (hit " << hit_count << ')' << ln;
+    }
+
 
     //-------------------- Console_Logger
 
-    Console_Logger::Console_Logger() noexcept : m_output { &std::cout } {}
+    Console_Logger::Console_Logger() : Logger { Descriptor_Writer::open_standard_output() } {}
+
+
+    //-------------------- Null_Logger
+
+    Null_Logger::Null_Logger() : Logger { std::make_unique<Null_Writer>() } {}
 
 
     //-------------------- File_Logger
 
-    File_Logger::File_Logger(std::string_view out_file) :
-        m_file_name { out_file },
-        m_output { m_file_name }
-    {
-        if (m_output.bad()) {
-            std::stringstream message {};
-            message << "Could not access file \"" << out_file << ".\"";
-            throw File_Open_Failure(message.str());
-        }
-        else if (!m_output.is_open()) {
-            std::stringstream message {};
-            message << "Could not open file \"" << out_file << ".\"";
-            throw File_Open_Failure(message.str());
-        }
-    }
+    File_Logger::File_Logger(std::string_view out_file, File_Output_Mode mode) : Logger { open_file_writer(out_file, mode) } {}
 }
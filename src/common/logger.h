@@ -4,51 +4,78 @@
 #include <string>
 #include <string_view>
 #include <ostream>
-#include <fstream>
+#include <memory>
+#include <cstdint>
+#include "output_sink.h"
 
 namespace svim {
+    struct Trace_Event;
+    struct Source_Location;
+    class Line_Table;
+
     class Logger {
     public:
         virtual void log_value(int value);
-        virtual void log_instruction(int instruction_index, const std::vector<int>& bytecode, int op_code);
+        // [location] is left out if unknown.
+        virtual void log_instruction(int instruction_index, const std::vector<int>& bytecode, int op_code, Source_Location location);
         virtual void log_global_data(const std::vector<int>& global_data);
         virtual void log_local_data(const int* data, int max_data_capacity);
         virtual void log_stack(const std::vector<int>& stack);
         virtual void log_compiled_source_code(const std::vector<int>& compiled_code);
+        virtual void log_line_table(const Line_Table& lines);
         virtual void output_invalid_op_code(int bad_op_code);
+        // Renders a recorded instruction like log_instruction() followed by log_stack(),
+        //     showing only the stack values the event kept.
+        virtual void log_trace_event(const Trace_Event& event, Source_Location location);
+        virtual void log_skipped_trace_events(std::uint64_t count);
+        // [hit_count] includes this hit.
+        virtual void log_tracepoint(int instruction_index, std::uint64_t hit_count);
+
+        // Lets hot paths write values without going through the virtual functions above.
+        Output_Sink& get_sink() { return m_sink; }
+        void flush() { m_sink.flush(); }
 
         virtual ~Logger() = default;
 
     protected:
-        virtual std::ostream& get_output() = 0;
+        explicit Logger(std::unique_ptr<Output_Writer>&& writer);
+
+        std::ostream& get_output() { return m_sink.get_stream(); }
+
+    private:
+        Output_Sink m_sink;
     };
 
 
     class Console_Logger : public Logger {
     public:
-        Console_Logger() noexcept;
+        Console_Logger();
+    };
 
-    protected:
-        std::ostream& get_output() override { return *m_output; }
 
-    private:
-        std::ostream* m_output;
+    // Formats and counts output like any other Logger, then throws it away.
+    class Null_Logger : public Logger {
+    public:
+        Null_Logger();
+    };
+
+
+    enum class File_Output_Mode {
+        // Written from the interpreting thread as the output buffer fills.
+        direct,
+        // Handed to a background thread, which does all of the writing.
+        asynchronous,
+        // Copied into a preallocated, memory-mapped window of the file, where supported.
+        mapped
     };
 
 
     class File_Logger : public Logger {
     public:
-        File_Logger(std::string_view out_file);
+        File_Logger(std::string_view out_file, File_Output_Mode mode = File_Output_Mode::direct);
 
-        // No reason to allow access to the file stream it controls.
+        // No reason to allow access to the file it controls.
         File_Logger(const File_Logger& other) = delete;
         File_Logger& operator =(const File_Logger& other) = delete;
-
-    protected:
-        std::ostream& get_output() override { return m_output; }
-
-    private:
-        std::string m_file_name {};
-        std::ofstream m_output {};
     };
 }
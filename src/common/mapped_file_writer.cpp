@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "mapped_file_writer.h"
+#include "error.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace svim {
+#if defined(_WIN32)
+    //----------- Mapped_File_Writer
+
+    std::unique_ptr<Output_Writer> Mapped_File_Writer::open_file(std::string_view file_name) {
+        return Descriptor_Writer::open_file(file_name);
+    }
+#else
+    //----------- Helper Functions
+
+    // Reserves disk space for [length] bytes starting at [offset], extending the file to cover them.
+    static bool preallocate(int descriptor, std::size_t offset, std::size_t length) {
+#if defined(__linux__)
+        if (::posix_fallocate(descriptor, static_cast<off_t>(offset), static_cast<off_t>(length)) == 0) {
+            return true;
+        }
+#endif
+
+        // Without real preallocation, the file still has to be long enough to map.
+        return ::ftruncate(descriptor, static_cast<off_t>(offset + length)) == 0;
+    }
+
+
+    //----------- Mapped_File_Writer
+
+    Mapped_File_Writer::Mapped_File_Writer(int descriptor) noexcept : m_descriptor { descriptor } {}
+
+    std::unique_ptr<Output_Writer> Mapped_File_Writer::open_file(std::string_view file_name) {
+        const int descriptor { ::open(std::string(file_name).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) };
+
+        if (descriptor < 0) {
+            std::stringstream message {};
+            message << "Could not open file \"" << file_name << ".\"";
+            throw File_Open_Failure(message.str());
+        }
+
+        std::unique_ptr<Mapped_File_Writer> writer { new Mapped_File_Writer(descriptor) };
+
+        try {
+            writer->map_window(0);
+        }
+        catch (const std::runtime_error&) {
+            // Some file systems cannot be mapped, but can still be written to.
+            writer.reset();
+            return Descriptor_Writer::open_file(file_name);
+        }
+
+        return writer;
+    }
+
+    Mapped_File_Writer::~Mapped_File_Writer() {
+        const std::size_t length { m_window_offset + m_window_used };
+
+        unmap_window();
+
+        // Drops the unused part of the last preallocated window.
+        if (::ftruncate(m_descriptor, static_cast<off_t>(length)) != 0) {
+            std::cerr << "Could not trim output file to its final length.\n";
+        }
+
+        ::close(m_descriptor);
+    }
+
+    void Mapped_File_Writer::write(const char* data, std::size_t size) {
+        while (size > 0) {
+            if (m_window_used == s_window_size) {
+                map_window(m_window_offset + s_window_size);
+            }
+
+            const std::size_t free_space { s_window_size - m_window_used };
+            const std::size_t chunk { (size < free_space) ? size : free_space };
+
+            std::memcpy(m_window + m_window_used, data, chunk);
+            m_window_used += chunk;
+
+            data += chunk;
+            size -= chunk;
+        }
+    }
+
+    // The current window stays mapped until the next one is, so a failure leaves the writer as it was.
+    void Mapped_File_Writer::map_window(std::size_t offset) {
+        if (!preallocate(m_descriptor, offset, s_window_size)) {
+            throw std::runtime_error("Could not allocate space for output file.");
+        }
+
+        int flags { MAP_SHARED };
+#if defined(MAP_POPULATE)
+        // Faulting the whole window in up front beats taking a page fault every 4 KiB of output.
+        flags |= MAP_POPULATE;
+#endif
+
+        void* window { ::mmap(nullptr, s_window_size, PROT_READ | PROT_WRITE, flags, m_descriptor, static_cast<off_t>(offset)) };
+
+        if (window == MAP_FAILED) {
+            // Whatever this window was meant to hold never gets written, so the final length stops at its start.
+            throw std::runtime_error("Could not map output file into memory.");
+        }
+
+        unmap_window();
+
+        m_window = static_cast<char*>(window);
+        m_window_offset = offset;
+        m_window_used = 0;
+        ::madvise(m_window, s_window_size, MADV_SEQUENTIAL);
+    }
+
+    void Mapped_File_Writer::unmap_window() {
+        if (m_window == nullptr) {
+            return;
+        }
+
+        // Starts writing the finished window back to disk without waiting for it, then drops its pages from
+        //     this process; the written data stays in the page cache.
+        ::msync(m_window, s_window_size, MS_ASYNC);
+        ::madvise(m_window, s_window_size, MADV_DONTNEED);
+        ::munmap(m_window, s_window_size);
+        m_window = nullptr;
+    }
+#endif
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include "output_sink.h"
+
+namespace svim {
+    // Copies output straight into the page cache through a moving window of the file mapped into memory.
+    // Each window is preallocated on disk before it is mapped, and the file is cut down to what was written
+    //     once the writer is destroyed.
+    class Mapped_File_Writer final : public Output_Writer {
+    public:
+        // Creates [file_name], or empties it if it exists.
+        // Where files cannot be mapped, this gives a Descriptor_Writer instead.
+        static std::unique_ptr<Output_Writer> open_file(std::string_view file_name);
+
+        ~Mapped_File_Writer() override;
+
+        void write(const char* data, std::size_t size) override;
+        // The mapped window, which is backed by the file rather than by memory of its own.
+        std::size_t get_buffer_bytes() const override { return (m_window != nullptr) ? s_window_size : 0; }
+
+        Mapped_File_Writer(const Mapped_File_Writer& other) = delete;
+        Mapped_File_Writer& operator =(const Mapped_File_Writer& other) = delete;
+
+    private:
+        inline static constexpr std::size_t s_window_size { 64 * 1024 * 1024 };
+
+        int m_descriptor {};
+        char* m_window {};
+        // File offset the current window starts at.
+        std::size_t m_window_offset {};
+        std::size_t m_window_used {};
+
+        explicit Mapped_File_Writer(int descriptor) noexcept;
+
+        void map_window(std::size_t offset);
+        void unmap_window();
+    };
+}
@@ -0,0 +1,175 @@
+#include "pch.h"
+#include "output_sink.h"
+#include "error.h"
+
+#include <cerrno>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace svim {
+    //----------- Helper Functions
+
+#if defined(_WIN32)
+    static constexpr int g_standard_output { 1 };
+
+    static long long write_descriptor(int descriptor, const char* data, std::size_t size) {
+        constexpr std::size_t max_chunk { 1u << 30 };
+        return _write(descriptor, data, static_cast<unsigned int>((size < max_chunk) ? size : max_chunk));
+    }
+
+    static int open_descriptor(const std::string& file_name) {
+        return _open(file_name.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    }
+
+    static void close_descriptor(int descriptor) {
+        _close(descriptor);
+    }
+#else
+    static constexpr int g_standard_output { STDOUT_FILENO };
+
+    static long long write_descriptor(int descriptor, const char* data, std::size_t size) {
+        return ::write(descriptor, data, size);
+    }
+
+    static int open_descriptor(const std::string& file_name) {
+        return ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    static void close_descriptor(int descriptor) {
+        ::close(descriptor);
+    }
+#endif
+
+
+    //----------- Descriptor_Writer
+
+    Descriptor_Writer::Descriptor_Writer(int descriptor, bool owned) noexcept :
+        m_descriptor { descriptor },
+        m_owned { owned } {}
+
+    Descriptor_Writer::~Descriptor_Writer() {
+        if (m_owned) {
+            close_descriptor(m_descriptor);
+        }
+    }
+
+    std::unique_ptr<Descriptor_Writer> Descriptor_Writer::open_standard_output() {
+        return std::make_unique<Descriptor_Writer>(g_standard_output, false);
+    }
+
+    std::unique_ptr<Descriptor_Writer> Descriptor_Writer::open_file(std::string_view file_name) {
+        const int descriptor { open_descriptor(std::string(file_name)) };
+
+        if (descriptor < 0) {
+            std::stringstream message {};
+            message << "Could not open file \"" << file_name << ".\"";
+            throw File_Open_Failure(message.str());
+        }
+
+        return std::make_unique<Descriptor_Writer>(descriptor, true);
+    }
+
+    void Descriptor_Writer::write(const char* data, std::size_t size) {
+        // Anything already sent through std::cout or stdout has to land before our output.
+        if (m_descriptor == g_standard_output) {
+            std::cout.flush();
+            std::fflush(stdout);
+        }
+
+        while (size > 0) {
+            const long long written { write_descriptor(m_descriptor, data, size) };
+
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::runtime_error("Could not write program output.");
+            }
+
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+
+
+    //----------- Output_Sink
+
+    Output_Sink::Output_Sink(std::unique_ptr<Output_Writer>&& writer) :
+        m_writer { std::move(writer) },
+        m_buffer(s_buffer_size),
+        m_stream_buffer { *this },
+        m_stream { &m_stream_buffer } {}
+
+    Output_Sink::~Output_Sink() {
+        try {
+            flush();
+        }
+        catch (...) {}
+    }
+
+    void Output_Sink::write(std::string_view text) {
+        if (text.size() > (m_buffer.size() - m_size)) {
+            spill();
+
+            // Too big to be worth copying.
+            if (text.size() >= m_buffer.size()) {
+                m_handed_over += text.size();
+                m_writer->write(text.data(), text.size());
+                return;
+            }
+        }
+
+        std::memcpy(m_buffer.data() + m_size, text.data(), text.size());
+        m_size += text.size();
+    }
+
+    void Output_Sink::write(char character) {
+        if (m_size == m_buffer.size()) {
+            spill();
+        }
+
+        m_buffer[m_size++] = character;
+    }
+
+    void Output_Sink::flush() {
+        spill();
+        m_writer->flush();
+    }
+
+    void Output_Sink::spill() {
+        if (m_size == 0) {
+            return;
+        }
+
+        // Emptied first so a failing writer does not get the same bytes again from the destructor.
+        const std::size_t size { m_size };
+        m_size = 0;
+        m_handed_over += size;
+        m_writer->write(m_buffer.data(), size);
+    }
+
+
+    //----------- Output_Sink::Stream_Buffer
+
+    Output_Sink::Stream_Buffer::int_type Output_Sink::Stream_Buffer::overflow(int_type character) {
+        if (!traits_type::eq_int_type(character, traits_type::eof())) {
+            m_sink.write(traits_type::to_char_type(character));
+        }
+
+        return traits_type::not_eof(character);
+    }
+
+    std::streamsize Output_Sink::Stream_Buffer::xsputn(const char_type* data, std::streamsize count) {
+        m_sink.write(std::string_view { data, static_cast<std::size_t>(count) });
+        return count;
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+namespace svim {
+    // Destination for the bytes an Output_Sink collects.
+    class Output_Writer {
+    public:
+        virtual void write(const char* data, std::size_t size) = 0;
+        // Called when everything written so far must reach its destination before continuing.
+        virtual void flush() {}
+        // Memory held for output that has not reached its destination yet, for memory reports.
+        virtual std::size_t get_buffer_bytes() const { return 0; }
+
+        virtual ~Output_Writer() = default;
+    };
+
+
+    // Writes straight to a file descriptor with write(2), bypassing the C and C++ stream buffers.
+    class Descriptor_Writer final : public Output_Writer {
+    public:
+        // Closes [descriptor] on destruction if [owned].
+        Descriptor_Writer(int descriptor, bool owned) noexcept;
+        ~Descriptor_Writer() override;
+
+        static std::unique_ptr<Descriptor_Writer> open_standard_output();
+        // Creates [file_name], or empties it if it exists.
+        static std::unique_ptr<Descriptor_Writer> open_file(std::string_view file_name);
+
+        void write(const char* data, std::size_t size) override;
+
+        Descriptor_Writer(const Descriptor_Writer& other) = delete;
+        Descriptor_Writer& operator =(const Descriptor_Writer& other) = delete;
+
+    private:
+        int m_descriptor {};
+        bool m_owned {};
+    };
+
+
+    // Throws away everything it is given, for runs whose output nobody reads, such as benchmarks.
+    class Null_Writer final : public Output_Writer {
+    public:
+        void write(const char*, std::size_t) override {}
+    };
+
+
+    // Collects output in a large buffer and only hands it to its Output_Writer once the buffer fills or on flush().
+    // Every "PRINT" goes through write_value(), so formatting is inlined here rather than hidden behind virtual calls.
+    class Output_Sink final {
+    public:
+        explicit Output_Sink(std::unique_ptr<Output_Writer>&& writer);
+        // Flushes whatever is left, ignoring write failures.
+        ~Output_Sink();
+
+        // Writes [value] on its own line.
+        void write_value(int value) {
+            if ((m_buffer.size() - m_size) < s_max_value_length) {
+                spill();
+            }
+
+            char* end { std::to_chars(m_buffer.data() + m_size, m_buffer.data() + m_buffer.size(), value).ptr };
+            *end = '\n';
+            m_size = static_cast<std::size_t>(end + 1 - m_buffer.data());
+        }
+
+        void write(std::string_view text);
+        void write(char character);
+        // Hands over everything buffered and waits for the writer to pass it on.
+        void flush();
+
+        // Counts buffered bytes too, whether or not they have reached the writer yet.
+        std::uint64_t get_bytes_written() const { return m_handed_over + m_size; }
+        // This sink's buffer along with any its writer keeps.
+        std::size_t get_buffer_bytes() const { return m_buffer.capacity() + m_writer->get_buffer_bytes(); }
+
+        // Stream over this sink for text that is not worth formatting by hand, such as trace output.
+        std::ostream& get_stream() { return m_stream; }
+
+        Output_Sink(const Output_Sink& other) = delete;
+        Output_Sink& operator =(const Output_Sink& other) = delete;
+
+    private:
+        class Stream_Buffer final : public std::streambuf {
+        public:
+            explicit Stream_Buffer(Output_Sink& sink) noexcept : m_sink { sink } {}
+
+        protected:
+            int_type overflow(int_type character) override;
+            std::streamsize xsputn(const char_type* data, std::streamsize count) override;
+
+        private:
+            Output_Sink& m_sink;
+        };
+
+        inline static constexpr std::size_t s_buffer_size { 64 * 1024 };
+        // Long enough for "-2147483648\n."
+        inline static constexpr std::size_t s_max_value_length { 12 };
+
+        std::unique_ptr<Output_Writer> m_writer {};
+        std::vector<char> m_buffer {};
+        std::size_t m_size {};
+        std::uint64_t m_handed_over {};
+
+        Stream_Buffer m_stream_buffer;
+        std::ostream m_stream;
+
+        // Hands over everything buffered without waiting on the writer.
+        void spill();
+    };
+}
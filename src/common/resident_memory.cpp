@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "resident_memory.h"
+
+#include <algorithm>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace svim {
+    std::uint64_t get_resident_bytes() {
+#if defined(__linux__)
+        // "/proc/self/statm" holds the total program size, then the resident size, in pages.
+        const int descriptor { ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC) };
+
+        if (descriptor < 0) {
+            return 0;
+        }
+
+        char text[128] {};
+        const ssize_t size { ::read(descriptor, text, sizeof(text) - 1) };
+        ::close(descriptor);
+
+        if (size <= 0) {
+            return 0;
+        }
+
+        const char* const end { text + size };
+        const char* const separator { std::find(static_cast<const char*>(text), end, ' ') };
+        std::uint64_t pages {};
+
+        if ((separator == end) || (std::from_chars(separator + 1, end, pages).ec != std::errc {})) {
+            return 0;
+        }
+
+        return pages * static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    std::uint64_t get_peak_resident_bytes() {
+#if defined(_WIN32)
+        return 0;
+#else
+        struct rusage usage {};
+
+        if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+
+        // Linux counts in kilobytes, macOS in bytes.
+#if defined(__APPLE__)
+        return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+        return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace svim {
+    // Bytes of this process currently held in physical memory. Read without allocating, so it can bracket
+    //     code whose allocations are being counted. 0 where the system does not report it; only Linux does.
+    std::uint64_t get_resident_bytes();
+
+    // Most bytes this process has held in physical memory at once, since it started. 0 on Windows.
+    std::uint64_t get_peak_resident_bytes();
+}
@@ -1,11 +1,18 @@
 #pragma once
 
-#include <ctime>
+#include <chrono>
+#include <cstdint>
 
 namespace svim {
-    using Milliseconds = int;
+    using Clock = std::chrono::steady_clock;
+    using Time_Point = Clock::time_point;
+    using Nanoseconds = std::chrono::nanoseconds;
 
-    inline Milliseconds get_current_time() {
-        return std::clock() / (CLOCKS_PER_SEC / 1000);
+    inline Time_Point get_current_time() {
+        return Clock::now();
+    }
+
+    inline std::int64_t get_elapsed_nanoseconds(Time_Point start, Time_Point end) {
+        return std::chrono::duration_cast<Nanoseconds>(end - start).count();
     }
 }
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "application.h"
 #include "program.h"
+#include "benchmark_report.h"
 #include "virtual_machine/virtual_machine.h"
 #include "virtual_machine/parser.h"
 #include "virtual_machine/instructions.h"
@@ -8,6 +9,11 @@
 #include "common/error.h"
 #include "common/timer.h"
 #include "common/debug.h"
+#include "common/hardware_counters.h"
+#include "common/allocation_counter.h"
+#include "common/resident_memory.h"
+
+#include <iomanip>
 
 namespace svim {
     //----------- Internal Types
@@ -31,33 +37,266 @@ namespace svim {
         }
     };
 
+    struct Flag final {
+        static constexpr std::string_view s_prefix { "--" };
+        static constexpr char s_value_separator { '=' };
+
+        std::string_view name {};
+        Application::Setting setting {};
+        bool takes_value {};
+        std::string_view description {};
+
+        static constexpr bool is_flag(std::string_view arg) {
+            return arg.substr(0, s_prefix.size()) == s_prefix;
+        }
+    };
+
     struct Parse_Result final {
         std::vector<int> bytecode {};
         Parser::Status status {};
         int program_starting_index {};
+        Line_Table lines {};
+    };
+
+    // Time, in nanoseconds, heap allocations, and change in resident memory, in bytes, of one phase of a run.
+    struct Phase_Cost final {
+        std::int64_t time {};
+        Allocation_Counts allocations {};
+        // Left as the clock's epoch for phases that never ran.
+        Time_Point start {};
+        std::int64_t resident_change {};
+    };
+
+    // Starts measuring a phase when constructed.
+    struct Phase_Timer final {
+        // Read first and last, so reading it is left out of the phase's time.
+        std::uint64_t start_resident { get_resident_bytes() };
+        Time_Point start_time { get_current_time() };
+        Allocation_Counts start_allocations { get_allocation_counts() };
+
+        Phase_Cost end() const {
+            const Time_Point end_time { get_current_time() };
+            const Allocation_Counts allocations { get_allocation_counts() - start_allocations };
+            const std::int64_t resident_change { static_cast<std::int64_t>(get_resident_bytes()) - static_cast<std::int64_t>(start_resident) };
+
+            return { get_elapsed_nanoseconds(start_time, end_time), allocations, start_time, resident_change };
+        }
+    };
+
+    // Everything "--stats" reports.
+    struct Run_Statistics final {
+        Phase_Cost parse {};
+        Phase_Cost optimize {};
+        Phase_Cost load {};
+        Phase_Cost execute {};
+        std::uint64_t instructions {};
+        Execution_Stats execution {};
+        std::uint64_t output_bytes {};
+        Memory_Report memory {};
+        std::uint64_t peak_resident {};
     };
 
-    static const std::array<Command, 5> s_options { {
+    static const std::array<Command, 8> s_options { {
             { "-h", Application::Process::print_help,       "print available options (no 'source_file' necessary)" },
             { "-c", Application::Process::output_console,   "run 'source_file,' outputting to console" },
             { "-f", Application::Process::output_file,      "run 'source_file,' outputting to file" },
             { "-d", Application::Process::dump_code,        "parse 'source_file' without running, outputting parsed contents to file" },
-            { "-e", Application::Process::demo_program,     "run example_program, outputting to console in trace mode" }
+            { "-e", Application::Process::demo_program,     "run example_program, outputting to console in trace mode" },
+            { "-t", Application::Process::decode_trace,     "render binary trace 'source_file' (recorded with --trace) to console in trace mode format" },
+            { "-m", Application::Process::watch_metrics,    "watch the live metrics a running program publishes under name 'source_file' (see --live-metrics)" },
+            { "-b", Application::Process::benchmark,        "parse 'source_file' once, then time repeated runs of it with output discarded (see --runs)" }
         } };
 
 
+    static const std::array<Flag, 27> s_flags { {
+            { "--no-optimize", Application::Setting::no_optimize, false, "run the program exactly as parsed, skipping bytecode optimization" },
+            { "--unroll", Application::Setting::unroll_factor, true, "iterations per unrolled counted loop (default 4; 1 disables unrolling)" },
+            { "--pgo-record", Application::Setting::profile_record, true, "record branch and block execution counts into the given profile file" },
+            { "--pgo-use", Application::Setting::profile_use, true, "lay out code using a profile recorded with the same settings" },
+            { "--async", Application::Setting::async_output, false, "write output files from a background thread" },
+            { "--mmap", Application::Setting::mapped_output, false, "write output files through preallocated memory-mapped windows" },
+            { "--trace", Application::Setting::trace_file, true, "record executed instructions into the given binary trace file (see -t)" },
+            { "--trace-size", Application::Setting::trace_size, true, "number of most recent instructions --trace keeps (default 1048576)" },
+            { "--trace-spill", Application::Setting::trace_spill, false, "save every instruction --trace records rather than only the most recent" },
+            { "--tracepoint", Application::Setting::tracepoint, true, "log the machine's state whenever the instructions at the given comma-separated indices run" },
+            { "--stats", Application::Setting::stats, false, "print phase timings and execution counters to stderr after the program ends" },
+            { "--stats-json", Application::Setting::stats_json, false, "same as --stats, formatted as a JSON object" },
+            { "--opcode-profile", Application::Setting::opcode_profile, true, "count executed opcodes, pairs, and triples, adding them to the given profile file" },
+            { "--profile", Application::Setting::sampling_profile, true, "sample the running code on a CPU timer, saving collapsed call stacks into the given file" },
+            { "--profile-interval", Application::Setting::sampling_interval, true, "microseconds of CPU time between --profile samples (default 1000)" },
+            { "--perf", Application::Setting::hardware_counters, false, "count CPU cycles, branch misses, and cache misses while the program runs (Linux only)" },
+            { "--call-profile", Application::Setting::call_profile, false, "print each function's calls, instructions, time, and callers to stderr after the program ends" },
+            { "--coverage", Application::Setting::coverage, true, "mark every instruction and branch direction run, adding them to the given coverage file" },
+            { "--live-metrics", Application::Setting::live_metrics, true, "publish running counters under the given name in /dev/shm for -m to watch (POSIX only)" },
+            { "--live-interval", Application::Setting::live_interval, true, "milliseconds between --live-metrics updates (default 100)" },
+            { "--timeline", Application::Setting::timeline_file, true, "save phase and function call spans into the given file as Chrome trace-event JSON" },
+            { "--timeline-size", Application::Setting::timeline_size, true, "most function calls --timeline keeps (default 1048576)" },
+            { "--timeline-min-call", Application::Setting::timeline_minimum_call, true, "leave calls shorter than the given microseconds out of --timeline (default 0)" },
+            { "--runs", Application::Setting::benchmark_runs, true, "number of times -b runs the program (default 10)" },
+            { "--baseline", Application::Setting::benchmark_baseline, true, "compare -b timings with the given report, failing if the median run regressed (see --save-baseline)" },
+            { "--save-baseline", Application::Setting::benchmark_save_baseline, true, "save -b timings into the given JSON report, unless they regressed against --baseline" },
+            { "--max-regression", Application::Setting::benchmark_threshold, true, "percent the median -b run may be slower than --baseline's before failing (default 5)" }
+        } };
+
+    // How many entries the "--opcode-profile" and "--profile" reports print.
+    static constexpr std::size_t g_profile_report_size { 10 };
+
+
     //----------- Helper Functions
 
     static void print_help() {
-        std::cout << "Command line format: option source_file [output_file/example_program]\n";
+        std::cout << "Command line format: option source_file [output_file/example_program] [settings]\n";
 
         for (const Command& command : s_options) {
             std::cout << '\t' << command.name << " (" << command.description << ")\n";
         }
+
+        std::cout << "Settings:\n";
+
+        for (const Flag& flag : s_flags) {
+            std::cout << '\t' << flag.name << ((flag.takes_value) ? "=value" : "") << " (" << flag.description << ")\n";
+        }
+    }
+
+    // Settings taking integers reject anything with trailing characters, such as "--unroll=4x."
+    static bool parse_setting_integer(std::string_view value, int& out_integer) {
+        const char* const end { value.data() + value.size() };
+        const std::from_chars_result result { std::from_chars(value.data(), end, out_integer) };
+        return (result.ec == std::errc {}) && (result.ptr == end);
+    }
+
+    static void print_elapsed_time(std::string_view subject, std::int64_t nanoseconds) {
+        std::cout << '\t' << subject << " duration = " << (static_cast<double>(nanoseconds) / 1e6) << " ms\n";
+    }
+
+    static double get_mips(const Run_Statistics& statistics) {
+        if (statistics.execute.time <= 0) {
+            return 0.0;
+        }
+
+        // Instructions per nanosecond, times 1000, gives millions of instructions per second.
+        return static_cast<double>(statistics.instructions) * 1e3 / static_cast<double>(statistics.execute.time);
+    }
+
+    static void print_statistics(const Run_Statistics& statistics) {
+        const auto print_phase = [](std::string_view name, const Phase_Cost& phase) {
+            std::cerr
+                << "    " << name << std::fixed << std::setprecision(3) << std::setw(12) << (static_cast<double>(phase.time) / 1e6) << " ms"
+                << std::setw(10) << phase.allocations.allocations << " allocations (" << phase.allocations.bytes << " bytes)"
+            << std::showpos << std::setw(12) << phase.resident_change << std::noshowpos << " bytes resident\n";
+        };
+
+        std::cerr << "Statistics:\n";
+        print_phase("Parse:          ", statistics.parse);
+        print_phase("Optimize:       ", statistics.optimize);
+        print_phase("Load:           ", statistics.load);
+        print_phase("Execute:        ", statistics.execute);
+        std::cerr
+            << "    Instructions:       " << statistics.instructions << '\n'
+            << "    MIPS:               " << std::setprecision(1) << get_mips(statistics) << '\n'
+            << "    Peak stack depth:   " << statistics.execution.peak_stack_depth << '\n'
+            << "    Peak call depth:    " << statistics.execution.peak_call_depth << '\n'
+            << "    Calls:              " << statistics.execution.calls << '\n'
+            << "    Output bytes:       " << statistics.output_bytes << '\n';
+        std::cerr.unsetf(std::ios::floatfield);
+
+        const Memory_Report& memory { statistics.memory };
+
+        std::cerr
+            << "Memory (bytes):\n"
+            << "    Machine:            " << memory.machine_bytes << '\n'
+            << "    Code:               " << memory.code_bytes << '\n'
+            << "    Operand stack:      " << memory.stack_bytes << " (" << memory.stack_capacity << " values, "
+            << statistics.execution.peak_stack_depth << " used at most)\n"
+            << "    Call stack:         " << memory.call_stack_bytes << " (" << memory.call_stack_capacity << " frames, "
+            << statistics.execution.peak_call_depth << " used at most)\n"
+            << "    Globals:            " << memory.global_bytes << " (" << memory.global_values << " values, "
+            << memory.globals_referenced << " named by the code)\n"
+            << "    Output buffers:     " << memory.output_buffer_bytes << '\n'
+            << "    Instrumentation:    " << memory.instrumentation_bytes << '\n'
+            << "    Total:              " << memory.get_total_bytes() << '\n'
+            << "    Peak resident:      " << statistics.peak_resident << " (whole process)\n";
+    }
+
+    static void print_hardware_counters(const Hardware_Counters& counters, std::uint64_t instructions) {
+        using Counter = Hardware_Counters::Counter;
+
+        std::cerr << "Hardware counters (execute phase):\n" << std::fixed << std::setprecision(3);
+
+        for (std::size_t i {}; i < Hardware_Counters::s_counter_count; ++i) {
+            const Counter counter { static_cast<Counter>(i) };
+            std::cerr << "    " << std::setw(16) << std::left << Hardware_Counters::get_name(counter) << std::right;
+
+            if (!counters.is_available(counter)) {
+                std::cerr << "unavailable\n";
+                continue;
+            }
+
+            const std::uint64_t count { counters.read(counter) };
+            std::cerr << std::setw(14) << count;
+
+            // Every SVIM instruction is one dispatch, so this doubles as e.g. mispredicts per dispatch.
+            if (instructions > 0) {
+                std::cerr << "  (" << (static_cast<double>(count) / static_cast<double>(instructions)) << " per SVIM instruction)";
+            }
+
+            std::cerr << '\n';
+        }
+
+        if (counters.is_available(Counter::cycles) && counters.is_available(Counter::instructions) && (counters.read(Counter::cycles) > 0)) {
+            std::cerr
+                << "    Host instructions per cycle: "
+                << (static_cast<double>(counters.read(Counter::instructions)) / static_cast<double>(counters.read(Counter::cycles))) << '\n';
+        }
+
+        std::cerr.unsetf(std::ios::floatfield);
+    }
+
+    static void print_phase_json(std::string_view name, const Phase_Cost& phase) {
+        std::cerr
+            << '"' << name << "_ns\":" << phase.time
+            << ",\"" << name << "_allocations\":" << phase.allocations.allocations
+            << ",\"" << name << "_allocated_bytes\":" << phase.allocations.bytes
+            << ",\"" << name << "_resident_change_bytes\":" << phase.resident_change << ',';
+    }
+
+    // Phases that never ran, such as parsing an example program, are left out.
+    static void add_phase(Timeline& timeline, std::string_view name, const Phase_Cost& phase) {
+        if (phase.start != Time_Point {}) {
+            timeline.add_phase(name, phase.start, phase.time);
+        }
     }
 
-    static void print_elapsed_time(std::string_view subject, Milliseconds start, Milliseconds end) {
-        std::cout << '\t' << subject << " duration = " << end - start << " ms\n";
+    static void print_statistics_json(const Run_Statistics& statistics) {
+        const Memory_Report& memory { statistics.memory };
+
+        std::cerr << '{';
+        print_phase_json("parse", statistics.parse);
+        print_phase_json("optimize", statistics.optimize);
+        print_phase_json("load", statistics.load);
+        print_phase_json("execute", statistics.execute);
+        std::cerr
+            << "\"instructions\":" << statistics.instructions
+            << ",\"mips\":" << std::fixed << std::setprecision(3) << get_mips(statistics)
+            << ",\"peak_stack_depth\":" << statistics.execution.peak_stack_depth
+            << ",\"peak_call_depth\":" << statistics.execution.peak_call_depth
+            << ",\"calls\":" << statistics.execution.calls
+            << ",\"output_bytes\":" << statistics.output_bytes
+            << ",\"memory\":{\"machine_bytes\":" << memory.machine_bytes
+            << ",\"code_bytes\":" << memory.code_bytes
+            << ",\"stack_bytes\":" << memory.stack_bytes
+            << ",\"stack_capacity\":" << memory.stack_capacity
+            << ",\"call_stack_bytes\":" << memory.call_stack_bytes
+            << ",\"call_stack_capacity\":" << memory.call_stack_capacity
+            << ",\"global_bytes\":" << memory.global_bytes
+            << ",\"global_values\":" << memory.global_values
+            << ",\"globals_referenced\":" << memory.globals_referenced
+            << ",\"output_buffer_bytes\":" << memory.output_buffer_bytes
+            << ",\"instrumentation_bytes\":" << memory.instrumentation_bytes
+            << ",\"total_bytes\":" << memory.get_total_bytes()
+            << "},\"peak_resident_bytes\":" << statistics.peak_resident
+            << "}\n";
+        std::cerr.unsetf(std::ios::floatfield);
     }
 
     
@@ -88,6 +327,13 @@ namespace svim {
             return +m_status;
         }
 
+        SVIM_PRINT_LINE("Parsing settings...");
+        m_status = parse_settings();
+
+        if (m_status != Status::success) {
+            return +m_status;
+        }
+
         SVIM_PRINT_LINE("Parsing I/0 files...");
         m_status = parse_io_files();
 
@@ -120,6 +366,18 @@ namespace svim {
             m_status = run_demo_program();
             break;
 
+        case Process::decode_trace:
+            m_status = decode_trace_file();
+            break;
+
+        case Process::watch_metrics:
+            m_status = watch_live_metrics();
+            break;
+
+        case Process::benchmark:
+            m_status = run_benchmark();
+            break;
+
         case Process::print_help:
             print_help();
             m_status = Status::success;
@@ -135,6 +393,17 @@ namespace svim {
     }
 
     Application::Process Application::parse_option() {
+        // Settings may follow the target in any order, so we set them aside before counting arguments.
+        for (std::size_t i { Command::s_minimum_arg_count }; i < m_command_line_args.size();) {
+            if (Flag::is_flag(m_command_line_args[i])) {
+                m_setting_args.push_back(m_command_line_args[i]);
+                m_command_line_args.erase(m_command_line_args.begin() + i);
+            }
+            else {
+                ++i;
+            }
+        }
+
         if (!Command::is_within_arg_range(m_command_line_args.size())) {
             std::cerr
                 << "Invalid number of command line arguments (minimum = "
@@ -173,9 +442,217 @@ namespace svim {
         return Process::abort;
     }
 
+    Application::Status Application::parse_settings() {
+        for (std::string_view arg : m_setting_args) {
+            std::string_view name { arg };
+            std::string_view value {};
+            const std::size_t separator { arg.find(Flag::s_value_separator) };
+
+            if (separator != std::string_view::npos) {
+                name = arg.substr(0, separator);
+                value = arg.substr(separator + 1);
+            }
+
+            const Flag* match {};
+
+            for (const Flag& flag : s_flags) {
+                if (name == flag.name) {
+                    match = &flag;
+                    break;
+                }
+            }
+
+            if (match == nullptr) {
+                std::cerr
+                    << "Invalid setting \""
+                    << name
+                    << "\" given. Enter \""
+                    << s_options[0].name
+                    << "\" to show available settings.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            if (match->takes_value == value.empty()) {
+                std::cerr
+                    << "Setting \"" << match->name << "\" "
+                    << ((match->takes_value) ? "requires a value." : "does not take a value.") << '\n';
+                return Status::invalid_command_line_args_error;
+            }
+
+            Status status { apply_setting(match->setting, value) };
+
+            if (status != Status::success) {
+                return status;
+            }
+        }
+
+        return Status::success;
+    }
+
+    Application::Status Application::apply_setting(Setting setting, std::string_view value) {
+        switch (setting) {
+        case Setting::no_optimize:
+            m_optimize = false;
+            return Status::success;
+
+        case Setting::unroll_factor:
+            if (!parse_setting_integer(value, m_optimizer_settings.unroll_factor) || (m_optimizer_settings.unroll_factor < 1)) {
+                std::cerr << "Unroll factor must be a positive integer.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        case Setting::profile_record:
+            m_profile_record_file = value;
+            return Status::success;
+
+        case Setting::profile_use:
+            m_profile_use_file = value;
+            return Status::success;
+
+        case Setting::async_output:
+            m_file_output_mode = File_Output_Mode::asynchronous;
+            return Status::success;
+
+        case Setting::mapped_output:
+            m_file_output_mode = File_Output_Mode::mapped;
+            return Status::success;
+
+        case Setting::trace_file:
+            m_trace_file = value;
+            return Status::success;
+
+        case Setting::trace_size:
+            if (!parse_setting_integer(value, m_trace_capacity) || (m_trace_capacity < 1)) {
+                std::cerr << "Trace size must be a positive integer.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        case Setting::trace_spill:
+            m_trace_spill = true;
+            return Status::success;
+
+        case Setting::stats:
+            m_stats_format = Stats_Format::text;
+            return Status::success;
+
+        case Setting::stats_json:
+            m_stats_format = Stats_Format::json;
+            return Status::success;
+
+        case Setting::opcode_profile:
+            m_opcode_profile_file = value;
+            return Status::success;
+
+        case Setting::call_profile:
+            m_call_profile = true;
+            return Status::success;
+
+        case Setting::coverage:
+            m_coverage_file = value;
+            return Status::success;
+
+        case Setting::hardware_counters:
+            m_hardware_counters = true;
+            return Status::success;
+
+        case Setting::timeline_file:
+            m_timeline_file = value;
+            return Status::success;
+
+        case Setting::timeline_size:
+            if (!parse_setting_integer(value, m_timeline_capacity) || (m_timeline_capacity < 1)) {
+                std::cerr << "Timeline size must be a positive number of calls.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        case Setting::timeline_minimum_call:
+            if (!parse_setting_integer(value, m_timeline_minimum_call) || (m_timeline_minimum_call < 0)) {
+                std::cerr << "Shortest timeline call must be a non-negative number of microseconds.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        case Setting::live_metrics:
+            m_live_metrics_name = value;
+            return Status::success;
+
+        case Setting::live_interval:
+            if (!parse_setting_integer(value, m_live_interval) || (m_live_interval < 1)) {
+                std::cerr << "Live metrics interval must be a positive number of milliseconds.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        case Setting::benchmark_runs:
+            if (!parse_setting_integer(value, m_benchmark_runs) || (m_benchmark_runs < 1)) {
+                std::cerr << "Benchmark runs must be a positive integer.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        case Setting::benchmark_baseline:
+            m_benchmark_baseline_file = value;
+            return Status::success;
+
+        case Setting::benchmark_save_baseline:
+            m_benchmark_save_baseline_file = value;
+            return Status::success;
+
+        case Setting::benchmark_threshold:
+            if (!parse_setting_integer(value, m_benchmark_threshold) || (m_benchmark_threshold < 0)) {
+                std::cerr << "Maximum regression must be a non-negative percentage.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        case Setting::sampling_profile:
+            m_sampling_profile_file = value;
+            return Status::success;
+
+        case Setting::sampling_interval:
+            if (!parse_setting_integer(value, m_sampling_interval) || (m_sampling_interval < 1)) {
+                std::cerr << "Profile interval must be a positive number of microseconds.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            return Status::success;
+
+        // May be given more than once; every occurrence adds to the list.
+        case Setting::tracepoint:
+            while (!value.empty()) {
+                const std::size_t separator { value.find(',') };
+                int address {};
+
+                if (!parse_setting_integer(value.substr(0, separator), address) || (address < 0)) {
+                    std::cerr << "Tracepoints must be non-negative bytecode indices separated by ','.\n";
+                    return Status::invalid_command_line_args_error;
+                }
+
+                m_tracepoints.push_back(address);
+                value = (separator == std::string_view::npos) ? std::string_view {} : value.substr(separator + 1);
+            }
+
+            return Status::success;
+
+        default:
+            return Status::invalid_command_line_args_error;
+        }
+    }
+
     Application::Status Application::parse_io_files() {
         switch (m_process) {
         case Process::output_console:
+        case Process::benchmark:
             return set_input_file();
 
         case Process::output_file:
@@ -202,6 +679,17 @@ namespace svim {
         case Process::demo_program:
             return Status::success;
 
+        // Trace files and metrics names are not SVIM source files, so they skip the naming checks.
+        case Process::decode_trace:
+        case Process::watch_metrics:
+            if (m_command_line_args.size() < Command::s_maximum_arg_count) {
+                std::cerr << "Too few command line arguments given for operation.\n";
+                return Status::invalid_command_line_args_error;
+            }
+
+            m_input_file = m_command_line_args[2];
+            return Status::success;
+
         default:
             return Status::invalid_command_line_args_error;
         }
@@ -290,12 +778,11 @@ namespace svim {
 
     Application::Status Application::dump_parsed_source() {
 #if SVIM_DEBUG
-        Milliseconds start { get_current_time() };
+        Time_Point start { get_current_time() };
 
         Parse_Result parser_result { run_parser(m_input_file) };
 
-        Milliseconds end { get_current_time() };
-        print_elapsed_time("Parser", start, end);
+        print_elapsed_time("Parser", get_elapsed_nanoseconds(start, get_current_time()));
 #else
         Parse_Result parser_result { run_parser(m_input_file) };
 #endif
@@ -308,6 +795,7 @@ namespace svim {
         try {
             File_Logger output { m_output_file };
             output.log_compiled_source_code(parser_result.bytecode);
+            output.log_line_table(parser_result.lines);
 
             return Application::Status::success;
         }
@@ -323,16 +811,47 @@ namespace svim {
         }
     }
 
+    Application::Status Application::decode_trace_file() {
+        try {
+            Console_Logger output {};
+            Trace_Buffer::decode(m_input_file, output);
+            return Status::success;
+        }
+        catch (const File_Open_Failure& exception) {
+            std::cerr << exception.what() << '\n';
+            return Status::file_open_error;
+        }
+        catch (const std::runtime_error& exception) {
+            std::cerr << exception.what() << '\n';
+            return Status::invalid_file_format;
+        }
+    }
+
+    Application::Status Application::watch_live_metrics() {
+        try {
+            Live_Metrics::watch(m_input_file, std::cout);
+            return Status::success;
+        }
+        catch (const File_Open_Failure& exception) {
+            std::cerr << exception.what() << '\n';
+            return Status::file_open_error;
+        }
+        catch (const std::runtime_error& exception) {
+            std::cerr << exception.what() << '\n';
+            return Status::invalid_file_format;
+        }
+    }
+
     Application::Status Application::run_user_program() {
-#if SVIM_DEBUG
-        Milliseconds start { get_current_time() };
+        Run_Statistics statistics {};
+        Phase_Timer parse_timer {};
 
         Parse_Result parser_result { run_parser(m_input_file) };
 
-        Milliseconds end { get_current_time() };
-        print_elapsed_time("Parser", start, end);
-#else
-        Parse_Result parser_result { run_parser(m_input_file) };
+        statistics.parse = parse_timer.end();
+
+#if SVIM_DEBUG
+        print_elapsed_time("Parser", statistics.parse.time);
 #endif
 
         if (parser_result.status != Parser::Status::success) {
@@ -340,14 +859,28 @@ namespace svim {
             return m_status;
         }
 
+        Phase_Timer optimize_timer {};
+        run_optimizer(parser_result.bytecode, parser_result.program_starting_index, parser_result.lines);
+        statistics.optimize = optimize_timer.end();
+
+#if SVIM_DEBUG
+        print_elapsed_time("Optimizer", statistics.optimize.time);
+#endif
+
         try {
             std::unique_ptr<Logger> logger {
                 (m_process == Process::output_console)
                 ? static_cast<Logger*>(new Console_Logger())
-                : static_cast<Logger*>(new File_Logger(m_output_file))
+                : static_cast<Logger*>(new File_Logger(m_output_file, m_file_output_mode))
             };
 
-            return run_interpreter(std::move(parser_result.bytecode), parser_result.program_starting_index, std::move(logger));
+            return run_interpreter(
+                std::move(parser_result.bytecode),
+                parser_result.program_starting_index,
+                std::move(parser_result.lines),
+                std::move(logger),
+                statistics
+            );
         }
         catch (const File_Open_Failure& exception) {
             std::cerr << exception.what() << '\n';
@@ -359,6 +892,84 @@ namespace svim {
         }
     }
 
+    Application::Status Application::run_benchmark() {
+        Phase_Timer parse_timer {};
+        Parse_Result parser_result { run_parser(m_input_file) };
+        const Phase_Cost parse { parse_timer.end() };
+
+        if (parser_result.status != Parser::Status::success) {
+            return Application::Status::parse_error;
+        }
+
+        Phase_Timer optimize_timer {};
+        run_optimizer(parser_result.bytecode, parser_result.program_starting_index, parser_result.lines);
+        const Phase_Cost optimize { optimize_timer.end() };
+
+        std::vector<std::int64_t> execute_times {};
+        execute_times.reserve(static_cast<std::size_t>(m_benchmark_runs));
+        std::uint64_t instructions {};
+
+        try {
+            for (int run {}; run < m_benchmark_runs; ++run) {
+                // Every run gets a machine of its own, so no stack, global, or output state carries over.
+                // Copying the code in happens before the clock starts.
+                Virtual_Machine vm {
+                    std::vector<int> { parser_result.bytecode },
+                    parser_result.program_starting_index,
+                    new Null_Logger()
+                };
+                vm.set_line_table(&parser_result.lines);
+
+                const Time_Point start { get_current_time() };
+                const Status result { vm.interpret() };
+                execute_times.push_back(get_elapsed_nanoseconds(start, get_current_time()));
+
+                if (result != Status::success) {
+                    std::cerr << "Run " << (run + 1) << " of \"" << m_input_file << "\" failed. Stopping the benchmark.\n";
+                    return result;
+                }
+
+                instructions = vm.get_instructions_retired();
+            }
+        }
+        catch (const std::exception& exception) {
+            std::cerr << exception.what() << '\n';
+            return Status::script_execution_failure;
+        }
+
+        const Benchmark_Report report { m_input_file, parse.time, optimize.time, instructions, std::move(execute_times) };
+        report.print(std::cout);
+
+        try {
+            if (!m_benchmark_baseline_file.empty()) {
+                const Benchmark_Report baseline { Benchmark_Report::load(m_benchmark_baseline_file) };
+
+                if (!report.compare(baseline, m_benchmark_threshold, std::cout)) {
+                    // Saving now would make the regression the next run's baseline.
+                    if (!m_benchmark_save_baseline_file.empty()) {
+                        std::cerr << "Baseline \"" << m_benchmark_save_baseline_file << "\" was left unchanged.\n";
+                    }
+
+                    return Status::benchmark_regression;
+                }
+            }
+
+            if (!m_benchmark_save_baseline_file.empty()) {
+                report.save(m_benchmark_save_baseline_file);
+            }
+
+            return Status::success;
+        }
+        catch (const File_Open_Failure& exception) {
+            std::cerr << exception.what() << '\n';
+            return Status::file_open_error;
+        }
+        catch (const std::runtime_error& exception) {
+            std::cerr << exception.what() << '\n';
+            return Status::invalid_file_format;
+        }
+    }
+
     Application::Status Application::run_demo_program() {
         if (m_command_line_args.size() < Command::s_maximum_arg_count) {
             std::cerr << "Too few command line arguments given for operation.\n";
@@ -382,8 +993,22 @@ namespace svim {
             //     of the move semantics inside of Virtual_Machine's constructor,
             //     and we wish to maintain the integrity of the demo program's pre-parsed source code.
             std::vector<int> bytecode { match->bytecode };
+            int starting_point { match->starting_point };
+            // Demo programs were never written out as source.
+            Line_Table lines {};
+
+            // Demo programs come already parsed, so there is no parse phase to report.
+            Run_Statistics statistics {};
+            Phase_Timer optimize_timer {};
+
+            run_optimizer(bytecode, starting_point, lines);
+            statistics.optimize = optimize_timer.end();
+
+#if SVIM_DEBUG
+            print_elapsed_time("Optimizer", statistics.optimize.time);
+#endif
 
-            return run_interpreter(std::move(bytecode), match->starting_point, std::move(std::make_unique<Console_Logger>()));
+            return run_interpreter(std::move(bytecode), starting_point, std::move(lines), std::move(std::make_unique<Console_Logger>()), statistics);
         }
         else {
             std::cerr
@@ -408,7 +1033,7 @@ namespace svim {
             Parser parser { file_name };
             std::vector<int> bytecode { parser.parse() };
 
-            return { bytecode, parser.get_status(), parser.get_program_start_index() };
+            return { bytecode, parser.get_status(), parser.get_program_start_index(), parser.get_line_table() };
         }
         catch (const Bad_Parse& exception) {
             std::cerr << exception.what() << '\n';
@@ -424,35 +1049,247 @@ namespace svim {
         }
     }
 
+    void Application::run_optimizer(std::vector<int>& bytecode, int& program_starting_point, Line_Table& lines) const {
+        if (!m_optimize) {
+            return;
+        }
+
+        Optimizer::Settings settings { m_optimizer_settings };
+        Execution_Profile profile {};
+
+        if (!m_profile_use_file.empty()) {
+            try {
+                profile = Execution_Profile::load(m_profile_use_file);
+                settings.profile = &profile;
+            }
+            catch (const std::exception& exception) {
+                std::cerr << exception.what() << " Continuing without profile.\n";
+            }
+        }
+
+        Optimizer optimizer { std::move(bytecode), program_starting_point, settings };
+        bytecode = optimizer.optimize();
+        program_starting_point = optimizer.get_program_start_index();
+        lines = optimizer.map_line_table(lines);
+
+        if ((settings.profile != nullptr) && !optimizer.is_profile_applied()) {
+            std::cerr
+                << "Profile \"" << m_profile_use_file
+                << "\" was recorded from different bytecode or settings. Continuing without profile.\n";
+        }
+    }
+
+    void Application::save_timeline(Timeline& timeline, const Run_Statistics& statistics, const Line_Table& lines) const {
+        add_phase(timeline, "parse", statistics.parse);
+        add_phase(timeline, "optimize", statistics.optimize);
+        add_phase(timeline, "load", statistics.load);
+        add_phase(timeline, "execute", statistics.execute);
+        timeline.save(m_timeline_file, lines);
+
+        if (timeline.get_dropped_calls() > 0) {
+            std::cerr
+                << "Timeline kept its first " << m_timeline_capacity << " calls and dropped "
+                << timeline.get_dropped_calls() << " more. Raise --timeline-size to keep them.\n";
+        }
+    }
+
     Application::Status Application::run_interpreter(
         std::vector<int>&& compiled_source_code,
         int program_starting_point,
-        std::unique_ptr<Logger>&& logger
+        Line_Table&& lines,
+        std::unique_ptr<Logger>&& logger,
+        Run_Statistics& statistics
         ) const {
 
         try {
+            Phase_Timer load_timer {};
+
+            // Declared before the VM so that it outlives it, and still gets saved if the VM throws.
+            std::unique_ptr<Trace_Buffer> trace {};
+
+            if (!m_trace_file.empty()) {
+                trace = std::make_unique<Trace_Buffer>(m_trace_file, static_cast<std::size_t>(m_trace_capacity), m_trace_spill, lines);
+            }
+
             Virtual_Machine vm {
                 std::move(compiled_source_code),
                 program_starting_point,
                 logger.release()
             };
             vm.set_trace_mode(m_trace_mode);
+            vm.set_line_table(&lines);
+            vm.set_trace_buffer(trace.get());
+
+            if (m_stats_format != Stats_Format::none) {
+                vm.set_execution_stats(&statistics.execution);
+            }
+
+            // Large enough to be worth leaving unallocated unless asked for.
+            std::unique_ptr<Opcode_Profile> opcode_profile {};
+
+            if (!m_opcode_profile_file.empty()) {
+                opcode_profile = std::make_unique<Opcode_Profile>();
+                vm.set_opcode_profile(opcode_profile.get());
+            }
+
+            Call_Profile call_profile {};
+
+            if (m_call_profile) {
+                vm.set_call_profile(&call_profile);
+            }
+
+            Coverage coverage {};
+
+            if (!m_coverage_file.empty()) {
+                vm.set_coverage(&coverage);
+            }
+
+            std::unique_ptr<Timeline> timeline {};
+
+            if (!m_timeline_file.empty()) {
+                timeline = std::make_unique<Timeline>(static_cast<std::size_t>(m_timeline_capacity), std::int64_t { m_timeline_minimum_call } * 1000);
+                vm.set_timeline(timeline.get());
+            }
+
+            // Declared after the VM so its timer stops before the VM it signals goes away.
+            std::unique_ptr<Sampling_Profiler> sampling_profiler {};
+
+            if (!m_sampling_profile_file.empty()) {
+                sampling_profiler = std::make_unique<Sampling_Profiler>(m_sampling_interval);
+                vm.set_sampling_profiler(sampling_profiler.get());
+            }
+
+            // Declared after the VM for the same reason as the sampling profiler.
+            std::unique_ptr<Live_Metrics> live_metrics {};
+
+            if (!m_live_metrics_name.empty()) {
+                live_metrics = std::make_unique<Live_Metrics>(m_live_metrics_name, m_live_interval);
+                vm.set_live_metrics(live_metrics.get());
+            }
+
+            for (int address : m_tracepoints) {
+                try {
+                    vm.add_tracepoint(address);
+                }
+                catch (const std::runtime_error& exception) {
+                    std::cerr << exception.what() << '\n';
+                    return Status::invalid_command_line_args_error;
+                }
+            }
+
+            Execution_Profile profile {};
+
+            if (!m_profile_record_file.empty()) {
+                vm.set_execution_profile(&profile);
+            }
+
+            std::unique_ptr<Hardware_Counters> counters {};
+
+            if (m_hardware_counters) {
+                counters = std::make_unique<Hardware_Counters>();
+
+                // Containers and locked-down kernels commonly refuse perf_event_open.
+                if (!counters->is_available()) {
+                    std::cerr << "Hardware counters are unavailable on this system. Continuing without them.\n";
+                    counters.reset();
+                }
+            }
+
+            statistics.load = load_timer.end();
+
+            if (counters != nullptr) {
+                counters->start();
+            }
+
+            Phase_Timer execute_timer {};
 
-#if SVIM_DEBUG
-            Milliseconds start { get_current_time() };
-            
-            Status result { vm.interpret() };
-            
-            Milliseconds end { get_current_time() };
-            print_elapsed_time("Program", start, end);
-#else
             Status result { vm.interpret() };
+
+            // Before the execute phase ends, so the calls still running nest inside it.
+            if (timeline != nullptr) {
+                timeline->finish();
+            }
+
+            statistics.execute = execute_timer.end();
+
+            if (counters != nullptr) {
+                counters->stop();
+            }
+
+            if (sampling_profiler != nullptr) {
+                sampling_profiler->stop();
+            }
+
+            if (live_metrics != nullptr) {
+                live_metrics->stop();
+                vm.publish_live_metrics();
+                live_metrics->finish();
+            }
+
+            statistics.instructions = vm.get_instructions_retired();
+            statistics.output_bytes = vm.get_output_bytes();
+
+            if (m_stats_format != Stats_Format::none) {
+                statistics.memory = vm.get_memory_report();
+                statistics.peak_resident = get_peak_resident_bytes();
+            }
+
+#if SVIM_DEBUG
+            print_elapsed_time("Program", statistics.execute.time);
 #endif
 
             if ((result == Status::success) && m_trace_mode) {
                 vm.dump_bytecode();
             }
 
+            if (!m_profile_record_file.empty()) {
+                profile.save(m_profile_record_file);
+            }
+
+            if (trace != nullptr) {
+                trace->finish();
+            }
+
+            if (m_call_profile) {
+                call_profile.finish(statistics.instructions);
+                call_profile.print_report(std::cerr, lines);
+            }
+
+            if (timeline != nullptr) {
+                save_timeline(*timeline, statistics, lines);
+            }
+
+            if (sampling_profiler != nullptr) {
+                sampling_profiler->save_collapsed_stacks(m_sampling_profile_file);
+                sampling_profiler->print_hot_addresses(std::cerr, g_profile_report_size, lines);
+            }
+
+            if (opcode_profile != nullptr) {
+                opcode_profile->merge_into(m_opcode_profile_file);
+                opcode_profile->print_summary(std::cerr, g_profile_report_size);
+            }
+
+            if (!m_coverage_file.empty()) {
+                if (!coverage.merge_into(m_coverage_file, lines)) {
+                    std::cerr
+                        << "Coverage file \"" << m_coverage_file
+                        << "\" was recorded from different bytecode or settings. Replacing it.\n";
+                }
+
+                coverage.print_summary(std::cerr, lines);
+            }
+
+            if (counters != nullptr) {
+                print_hardware_counters(*counters, statistics.instructions);
+            }
+
+            if (m_stats_format == Stats_Format::text) {
+                print_statistics(statistics);
+            }
+            else if (m_stats_format == Stats_Format::json) {
+                print_statistics_json(statistics);
+            }
+
             return result;
         }
         catch (const std::runtime_error& exception) {
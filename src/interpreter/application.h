@@ -4,15 +4,19 @@
 #include <string>
 #include <string_view>
 #include <memory>
+#include "virtual_machine/optimizer.h"
+#include "common/logger.h"
 
 namespace svim {
     struct Parse_Result;
-    class Logger;
+    struct Run_Statistics;
+    class Timeline;
 
     class Application final {
     public:
         enum class Status {
             success = 0,
+            benchmark_regression = 1,
             file_not_found_error = 2,
             demo_program_not_found_error = 2,
             parse_error = 11,
@@ -24,6 +28,37 @@ namespace svim {
             unknown_error = -2
         };
 
+        // Optional settings given as "--name" or "--name=value" after the target.
+        enum class Setting {
+            no_optimize,
+            unroll_factor,
+            profile_record,
+            profile_use,
+            async_output,
+            mapped_output,
+            trace_file,
+            trace_size,
+            trace_spill,
+            tracepoint,
+            stats,
+            stats_json,
+            opcode_profile,
+            sampling_profile,
+            sampling_interval,
+            hardware_counters,
+            call_profile,
+            coverage,
+            live_metrics,
+            live_interval,
+            timeline_file,
+            timeline_size,
+            timeline_minimum_call,
+            benchmark_runs,
+            benchmark_baseline,
+            benchmark_save_baseline,
+            benchmark_threshold
+        };
+
         enum class Process {
             read_command,
             print_help,
@@ -31,6 +66,9 @@ namespace svim {
             output_file,
             dump_code,
             demo_program,
+            decode_trace,
+            watch_metrics,
+            benchmark,
             done,
             abort
         };
@@ -43,14 +81,48 @@ namespace svim {
         Application& operator =(const Application& other) = delete;
 
     private:
+        enum class Stats_Format {
+            none,
+            text,
+            json
+        };
+
         Status m_status { Status::success };
         Process m_process { Process::read_command };
         std::vector<std::string_view> m_command_line_args {};
+        std::vector<std::string_view> m_setting_args {};
         std::string m_input_file {};
         std::string m_output_file {};
         bool m_trace_mode {};
+        bool m_optimize { true };
+        Optimizer::Settings m_optimizer_settings {};
+        std::string m_profile_record_file {};
+        std::string m_profile_use_file {};
+        File_Output_Mode m_file_output_mode { File_Output_Mode::direct };
+        std::string m_trace_file {};
+        int m_trace_capacity { 1 << 20 };
+        bool m_trace_spill {};
+        std::vector<int> m_tracepoints {};
+        Stats_Format m_stats_format { Stats_Format::none };
+        std::string m_opcode_profile_file {};
+        std::string m_sampling_profile_file {};
+        int m_sampling_interval { 1000 };
+        bool m_hardware_counters {};
+        bool m_call_profile {};
+        std::string m_coverage_file {};
+        std::string m_live_metrics_name {};
+        int m_live_interval { 100 };
+        std::string m_timeline_file {};
+        int m_timeline_capacity { 1 << 20 };
+        int m_timeline_minimum_call {};
+        int m_benchmark_runs { 10 };
+        std::string m_benchmark_baseline_file {};
+        std::string m_benchmark_save_baseline_file {};
+        int m_benchmark_threshold { 5 };
 
         Process parse_option();
+        Status parse_settings();
+        Status apply_setting(Setting setting, std::string_view value);
         Status parse_io_files();
         Status execute_command();
         Status set_input_file();
@@ -60,13 +132,20 @@ namespace svim {
         Status run_user_program();
         Status run_demo_program();
         Status dump_parsed_source();
+        Status decode_trace_file();
+        Status watch_live_metrics();
+        Status run_benchmark();
 
         Parse_Result run_parser(std::string_view file_name) const;
+        void run_optimizer(std::vector<int>& bytecode, int& program_starting_point, Line_Table& lines) const;
         Application::Status run_interpreter(
             std::vector<int>&& compiled_source_code,
             int program_starting_point,
-            std::unique_ptr<Logger>&& logger
+            Line_Table&& lines,
+            std::unique_ptr<Logger>&& logger,
+            Run_Statistics& statistics
             ) const;
+        void save_timeline(Timeline& timeline, const Run_Statistics& statistics, const Line_Table& lines) const;
     };
 
     // A convenient shorthand for casting Application::Status values into integers.
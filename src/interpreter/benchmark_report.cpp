@@ -0,0 +1,184 @@
+#include "pch.h"
+#include "benchmark_report.h"
+#include "common/error.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace svim {
+    //----------- Helper Functions
+
+    // Nearest-rank percentile of sorted [times].
+    static std::int64_t get_percentile(const std::vector<std::int64_t>& times, int percent) {
+        const std::size_t rank { (times.size() * static_cast<std::size_t>(percent) + 99) / 100 };
+        return times[std::max<std::size_t>(rank, 1) - 1];
+    }
+
+    static double to_milliseconds(std::int64_t nanoseconds) {
+        return static_cast<double>(nanoseconds) / 1e6;
+    }
+
+    // Reports only hold numbers and a source file name, which has nothing to escape,
+    //     so values are found by their keys rather than with a full JSON parser.
+    static std::string_view find_json_value(std::string_view text, std::string_view key) {
+        const std::string quoted_key { '"' + std::string(key) + "\":" };
+        const std::size_t key_start { text.find(quoted_key) };
+
+        if (key_start == std::string_view::npos) {
+            return {};
+        }
+
+        const std::size_t value_start { key_start + quoted_key.size() };
+        const std::size_t value_end { text.find_first_of(",}", value_start) };
+
+        return text.substr(value_start, (value_end == std::string_view::npos) ? std::string_view::npos : value_end - value_start);
+    }
+
+    template<typename Integer>
+    static bool read_json_integer(std::string_view text, std::string_view key, Integer& out_integer) {
+        const std::string_view value { find_json_value(text, key) };
+        const char* const end { value.data() + value.size() };
+        const std::from_chars_result result { std::from_chars(value.data(), end, out_integer) };
+        return !value.empty() && (result.ec == std::errc {}) && (result.ptr == end);
+    }
+
+    static void print_change(std::ostream& output, std::string_view name, std::int64_t current, std::int64_t baseline) {
+        const double change { (baseline > 0) ? (static_cast<double>(current - baseline) * 100.0 / static_cast<double>(baseline)) : 0.0 };
+
+        output
+            << "    " << name << std::fixed << std::setprecision(3)
+            << std::setw(12) << to_milliseconds(baseline) << " ms ->"
+            << std::setw(12) << to_milliseconds(current) << " ms"
+            << std::setprecision(1) << std::showpos << std::setw(10) << change << '%' << std::noshowpos << '\n';
+        output.unsetf(std::ios::floatfield);
+    }
+
+
+    //----------- Benchmark_Report
+
+    Benchmark_Report::Benchmark_Report(
+        std::string_view source_file,
+        std::int64_t parse_time,
+        std::int64_t optimize_time,
+        std::uint64_t instructions,
+        std::vector<std::int64_t> execute_times
+        ) :
+        m_source_file { source_file },
+        m_runs { static_cast<int>(execute_times.size()) },
+        m_parse_time { parse_time },
+        m_optimize_time { optimize_time },
+        m_instructions { instructions }
+    {
+        if (execute_times.empty()) {
+            return;
+        }
+
+        std::sort(execute_times.begin(), execute_times.end());
+        m_minimum = execute_times.front();
+        m_median = get_percentile(execute_times, 50);
+        m_p99 = get_percentile(execute_times, 99);
+    }
+
+    Benchmark_Report Benchmark_Report::load(std::string_view report_file) {
+        std::ifstream input { std::string(report_file) };
+
+        if (!input.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open benchmark baseline \"" << report_file << ".\"";
+            throw File_Open_Failure(message.str());
+        }
+
+        std::ostringstream contents {};
+        contents << input.rdbuf();
+        const std::string text { contents.str() };
+
+        Benchmark_Report report {};
+        const std::string_view source_file { find_json_value(text, "source_file") };
+
+        const bool is_complete {
+            (source_file.size() >= 2) && (source_file.front() == '"') && (source_file.back() == '"') &&
+            read_json_integer(text, "runs", report.m_runs) &&
+            read_json_integer(text, "parse_ns", report.m_parse_time) &&
+            read_json_integer(text, "optimize_ns", report.m_optimize_time) &&
+            read_json_integer(text, "instructions", report.m_instructions) &&
+            read_json_integer(text, "min_ns", report.m_minimum) &&
+            read_json_integer(text, "median_ns", report.m_median) &&
+            read_json_integer(text, "p99_ns", report.m_p99)
+        };
+
+        if (!is_complete) {
+            std::ostringstream message {};
+            message << "File \"" << report_file << "\" is not a SVIM benchmark report.";
+            throw std::runtime_error(message.str());
+        }
+
+        report.m_source_file = source_file.substr(1, source_file.size() - 2);
+        return report;
+    }
+
+    void Benchmark_Report::save(std::string_view report_file) const {
+        std::ofstream output { std::string(report_file) };
+
+        if (!output.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open benchmark baseline \"" << report_file << "\" for writing.";
+            throw File_Open_Failure(message.str());
+        }
+
+        output
+            << "{\"source_file\":\"" << m_source_file << '"'
+            << ",\"runs\":" << m_runs
+            << ",\"parse_ns\":" << m_parse_time
+            << ",\"optimize_ns\":" << m_optimize_time
+            << ",\"instructions\":" << m_instructions
+            << ",\"min_ns\":" << m_minimum
+            << ",\"median_ns\":" << m_median
+            << ",\"p99_ns\":" << m_p99
+            << ",\"instructions_per_second\":" << std::fixed << std::setprecision(0) << get_instructions_per_second()
+            << "}\n";
+    }
+
+    void Benchmark_Report::print(std::ostream& output) const {
+        output
+            << "Benchmark of \"" << m_source_file << "\" (" << m_runs << " runs):\n" << std::fixed << std::setprecision(3)
+            << "    Parse:          " << std::setw(12) << to_milliseconds(m_parse_time) << " ms\n"
+            << "    Optimize:       " << std::setw(12) << to_milliseconds(m_optimize_time) << " ms\n"
+            << "    Execute min:    " << std::setw(12) << to_milliseconds(m_minimum) << " ms\n"
+            << "    Execute median: " << std::setw(12) << to_milliseconds(m_median) << " ms\n"
+            << "    Execute p99:    " << std::setw(12) << to_milliseconds(m_p99) << " ms\n"
+            << "    Instructions:   " << std::setw(12) << m_instructions << " per run\n"
+            << std::setprecision(1)
+            << "    MIPS:           " << std::setw(12) << (get_instructions_per_second() / 1e6) << " (median run)\n";
+        output.unsetf(std::ios::floatfield);
+    }
+
+    bool Benchmark_Report::compare(const Benchmark_Report& baseline, int threshold_percent, std::ostream& output) const {
+        output << "Compared with baseline (" << baseline.m_runs << " runs):\n";
+
+        if (baseline.m_source_file != m_source_file) {
+            output << "    Baseline was recorded from \"" << baseline.m_source_file << "\" rather than \"" << m_source_file << ".\"\n";
+        }
+
+        if (baseline.m_instructions != m_instructions) {
+            output << "    Baseline retired " << baseline.m_instructions << " instructions per run rather than " << m_instructions << ".\n";
+        }
+
+        print_change(output, "Parse:          ", m_parse_time, baseline.m_parse_time);
+        print_change(output, "Execute min:    ", m_minimum, baseline.m_minimum);
+        print_change(output, "Execute median: ", m_median, baseline.m_median);
+        print_change(output, "Execute p99:    ", m_p99, baseline.m_p99);
+
+        // Compared in integers, so thresholds of 0 flag any slowdown at all.
+        const bool is_regression { (m_median * 100) > (baseline.m_median * (100 + threshold_percent)) };
+
+        if (is_regression) {
+            output << "Median run regressed by more than " << threshold_percent << "%.\n";
+        }
+
+        return !is_regression;
+    }
+
+    double Benchmark_Report::get_instructions_per_second() const {
+        return (m_median > 0) ? (static_cast<double>(m_instructions) * 1e9 / static_cast<double>(m_median)) : 0.0;
+    }
+}
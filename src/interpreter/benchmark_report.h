@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+
+namespace svim {
+    // Timings of one program parsed once and executed repeatedly with "-b."
+    // Saved as a flat JSON object, which later runs load back as the baseline to compare against.
+    class Benchmark_Report final {
+    public:
+        // [execute_times], in nanoseconds, holds one entry per run; [instructions] are those retired by a single run.
+        Benchmark_Report(
+            std::string_view source_file,
+            std::int64_t parse_time,
+            std::int64_t optimize_time,
+            std::uint64_t instructions,
+            std::vector<std::int64_t> execute_times
+            );
+
+        static Benchmark_Report load(std::string_view report_file);
+        void save(std::string_view report_file) const;
+
+        void print(std::ostream& output) const;
+        // Prints how these timings differ from [baseline]'s. Returns false when the median run is slower than
+        //     [baseline]'s by more than [threshold_percent].
+        bool compare(const Benchmark_Report& baseline, int threshold_percent, std::ostream& output) const;
+
+        // Based on the median run.
+        double get_instructions_per_second() const;
+
+    private:
+        std::string m_source_file {};
+        int m_runs {};
+        std::int64_t m_parse_time {};
+        std::int64_t m_optimize_time {};
+        std::uint64_t m_instructions {};
+        std::int64_t m_minimum {};
+        std::int64_t m_median {};
+        std::int64_t m_p99 {};
+
+        Benchmark_Report() = default;
+    };
+}
@@ -20,6 +20,9 @@
 #include <memory>
 
 // Utilities
+#include <charconv>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <limits>
 #include <utility>
@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "call_profile.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace svim {
+    //----------- Helper Functions
+
+    static double to_milliseconds(std::int64_t nanoseconds) {
+        return static_cast<double>(nanoseconds) / 1e6;
+    }
+
+
+    //----------- Call_Profile
+
+    void Call_Profile::begin(int entry_index, std::uint64_t instructions_retired) {
+        m_functions[entry_index].is_main = true;
+        push_call(entry_index, instructions_retired);
+    }
+
+    void Call_Profile::enter(int entry_index, std::uint64_t instructions_retired) {
+        if (!m_active_calls.empty()) {
+            ++m_edges[{ m_active_calls.back().entry_index, entry_index }];
+        }
+
+        push_call(entry_index, instructions_retired);
+    }
+
+    void Call_Profile::tail_call(int entry_index, std::uint64_t instructions_retired) {
+        if (m_active_calls.empty()) {
+            return;
+        }
+
+        ++m_edges[{ m_active_calls.back().entry_index, entry_index }];
+        leave(instructions_retired);
+        push_call(entry_index, instructions_retired);
+    }
+
+    void Call_Profile::leave(std::uint64_t instructions_retired) {
+        if (m_active_calls.empty()) {
+            return;
+        }
+
+        const Active_Call call { m_active_calls.back() };
+        m_active_calls.pop_back();
+
+        const std::uint64_t inclusive_instructions { instructions_retired - call.start_instructions };
+        const std::int64_t inclusive_time { get_elapsed_nanoseconds(call.start_time, get_current_time()) };
+
+        Function_Costs& costs { m_functions[call.entry_index] };
+        costs.exclusive_instructions += inclusive_instructions - call.child_instructions;
+        costs.exclusive_time += inclusive_time - call.child_time;
+
+        if (--costs.active_calls == 0) {
+            costs.inclusive_instructions += inclusive_instructions;
+            costs.inclusive_time += inclusive_time;
+        }
+
+        if (!m_active_calls.empty()) {
+            m_active_calls.back().child_instructions += inclusive_instructions;
+            m_active_calls.back().child_time += inclusive_time;
+        }
+    }
+
+    void Call_Profile::finish(std::uint64_t instructions_retired) {
+        while (!m_active_calls.empty()) {
+            leave(instructions_retired);
+        }
+    }
+
+    void Call_Profile::push_call(int entry_index, std::uint64_t instructions_retired) {
+        Function_Costs& costs { m_functions[entry_index] };
+        ++costs.calls;
+        costs.max_depth = std::max(costs.max_depth, ++costs.active_calls);
+
+        m_active_calls.push_back({ entry_index, instructions_retired, get_current_time() });
+    }
+
+    void Call_Profile::print_report(std::ostream& output, const Line_Table& lines) const {
+        const std::vector<Line_Table::Row> rows { lines.get_rows() };
+
+        std::vector<std::pair<int, Function_Costs>> functions { m_functions.begin(), m_functions.end() };
+
+        std::sort(functions.begin(), functions.end(), [](const auto& a, const auto& b) {
+            if (a.second.exclusive_instructions != b.second.exclusive_instructions) {
+                return a.second.exclusive_instructions > b.second.exclusive_instructions;
+            }
+
+            return a.first < b.first;
+        });
+
+        const auto function_name = [this](int entry_index) {
+            const auto costs { m_functions.find(entry_index) };
+            std::ostringstream name {};
+
+            if ((costs != m_functions.end()) && costs->second.is_main) {
+                name << "main";
+            }
+            else {
+                name << "fn@" << entry_index;
+            }
+
+            return name.str();
+        };
+
+        output
+            << "Function profile:\n"
+            << "    " << std::left << std::setw(12) << "Function" << std::right
+            << std::setw(12) << "Calls"
+            << std::setw(16) << "Incl. instr."
+            << std::setw(16) << "Excl. instr."
+            << std::setw(12) << "Incl. ms"
+            << std::setw(12) << "Excl. ms"
+            << std::setw(10) << "Depth"
+            << std::setw(8) << "Line" << '\n'
+            << std::fixed << std::setprecision(3);
+
+        for (const auto& [entry_index, costs] : functions) {
+            output
+                << "    " << std::left << std::setw(12) << function_name(entry_index) << std::right
+                << std::setw(12) << costs.calls
+                << std::setw(16) << costs.inclusive_instructions
+                << std::setw(16) << costs.exclusive_instructions
+                << std::setw(12) << to_milliseconds(costs.inclusive_time)
+                << std::setw(12) << to_milliseconds(costs.exclusive_time)
+                << std::setw(10) << costs.max_depth;
+
+            const Source_Location location { Line_Table::find(rows, entry_index) };
+
+            if (location.is_known()) {
+                output << std::setw(8) << location.line;
+            }
+
+            output << '\n';
+        }
+
+        output << "Call graph:\n";
+
+        for (const auto& [edge, count] : m_edges) {
+            output << "    " << function_name(edge.first) << " -> " << function_name(edge.second) << "  " << count << '\n';
+        }
+
+        output.unsetf(std::ios::floatfield);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/timer.h"
+#include "line_table.h"
+
+namespace svim {
+    // Per-function costs gathered by Virtual_Machine as functions are entered and left.
+    // Functions are identified by the index they start at; the frame the program starts in counts as "main."
+    // Instruction counts come from the VM's count of retired instructions rather than from counting here,
+    //     so code between calls runs at full speed.
+    class Call_Profile final {
+    public:
+        Call_Profile() = default;
+
+        // Enters "main." [instructions_retired] is the VM's count so far.
+        void begin(int entry_index, std::uint64_t instructions_retired);
+        void enter(int entry_index, std::uint64_t instructions_retired);
+        // Leaves the current function and enters [entry_index] in its place, as "TCALL" does.
+        void tail_call(int entry_index, std::uint64_t instructions_retired);
+        void leave(std::uint64_t instructions_retired);
+        // Leaves every function still running, such as when "EXIT" is reached from inside one.
+        void finish(std::uint64_t instructions_retired);
+
+        // Prints every function, most exclusive instructions first, then every caller-to-callee edge.
+        // Functions are shown with the source line they start at if [lines] has it.
+        void print_report(std::ostream& output, const Line_Table& lines) const;
+
+        Call_Profile(const Call_Profile& other) = delete;
+        Call_Profile& operator =(const Call_Profile& other) = delete;
+
+    private:
+        struct Function_Costs {
+            std::uint64_t calls {};
+            // Inclusive costs are only added when the outermost call of a recursion returns,
+            //     so recursive functions are not counted once per level.
+            std::uint64_t inclusive_instructions {};
+            std::uint64_t exclusive_instructions {};
+            std::int64_t inclusive_time {};
+            std::int64_t exclusive_time {};
+            int active_calls {};
+            int max_depth {};
+            bool is_main {};
+        };
+
+        struct Active_Call {
+            int entry_index {};
+            std::uint64_t start_instructions {};
+            Time_Point start_time {};
+            std::uint64_t child_instructions {};
+            std::int64_t child_time {};
+        };
+
+        std::unordered_map<int, Function_Costs> m_functions {};
+        // Keyed by (caller, callee).
+        std::map<std::pair<int, int>, std::uint64_t> m_edges {};
+        std::vector<Active_Call> m_active_calls {};
+
+        void push_call(int entry_index, std::uint64_t instructions_retired);
+    };
+}
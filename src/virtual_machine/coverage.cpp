@@ -0,0 +1,208 @@
+#include "pch.h"
+#include "coverage.h"
+#include "execution_profile.h"
+#include "instructions.h"
+#include "common/error.h"
+
+#include <iomanip>
+#include <set>
+
+namespace svim {
+    //----------- Internal Data
+
+    static constexpr std::string_view g_coverage_header { "svim-coverage" };
+    static constexpr int g_coverage_version { 1 };
+
+
+    //----------- Helper Functions
+
+    static double get_percentage(std::size_t part, std::size_t whole) {
+        return (whole > 0) ? (100.0 * static_cast<double>(part) / static_cast<double>(whole)) : 100.0;
+    }
+
+    // Prints [lines] as comma-separated ranges, such as "3, 7-9, 12."
+    static void print_line_ranges(std::ostream& output, const std::set<int>& lines) {
+        auto current { lines.begin() };
+
+        while (current != lines.end()) {
+            const int first { *current };
+            int last { first };
+
+            while ((++current != lines.end()) && (*current == (last + 1))) {
+                last = *current;
+            }
+
+            output << first;
+
+            if (last != first) {
+                output << '-' << last;
+            }
+
+            if (current != lines.end()) {
+                output << ", ";
+            }
+        }
+    }
+
+
+    //----------- Coverage
+
+    void Coverage::reset(const std::vector<int>& bytecode) {
+        m_code_size = bytecode.size();
+        m_code_hash = Execution_Profile::hash(bytecode);
+        m_instructions.clear();
+        m_is_branch.assign(m_code_size, 0);
+        m_map.assign(m_code_size, 0);
+
+        for (std::size_t address {}; address < m_code_size;) {
+            const int op_code { bytecode[address] };
+
+            // Past here, there is no telling instructions from operands.
+            if ((op_code < 0) || (static_cast<std::size_t>(op_code) >= g_instruction_data.size())) {
+                break;
+            }
+
+            m_instructions.push_back(static_cast<int>(address));
+            m_is_branch[address] = (op_code == Instruction::brt) || (op_code == Instruction::brf);
+            address += 1 + g_instruction_data[op_code].expected_following_values;
+        }
+    }
+
+    bool Coverage::merge_into(std::string_view coverage_file, const Line_Table& lines) {
+        const bool merged { load(coverage_file) };
+        save(coverage_file, lines);
+        return merged;
+    }
+
+    bool Coverage::load(std::string_view coverage_file) {
+        std::ifstream input { std::string(coverage_file) };
+
+        // Nothing has been recorded into it yet.
+        if (!input.is_open()) {
+            return true;
+        }
+
+        std::string header {};
+        int version {};
+        std::size_t code_size {};
+        std::uint64_t code_hash {};
+        input >> header >> version >> code_size >> code_hash;
+
+        if (!input || (header != g_coverage_header) || (version != g_coverage_version)) {
+            std::ostringstream message {};
+            message << "File \"" << coverage_file << "\" is not a SVIM coverage file.";
+            throw std::runtime_error(message.str());
+        }
+
+        if ((code_size != m_code_size) || (code_hash != m_code_hash)) {
+            return false;
+        }
+
+        std::size_t address {};
+        int line {};
+        int executed {};
+        int taken {};
+        int fell_through {};
+
+        while (input >> address >> line >> executed >> taken >> fell_through) {
+            if ((address >= m_code_size) || (executed == 0)) {
+                continue;
+            }
+
+            m_map[address] |= s_executed;
+
+            if (m_is_branch[address] != 0) {
+                m_map[address + 1] |= ((taken != 0) ? s_taken : 0) | ((fell_through != 0) ? s_fell_through : 0);
+            }
+        }
+
+        return true;
+    }
+
+    void Coverage::save(std::string_view coverage_file, const Line_Table& lines) const {
+        std::ofstream output { std::string(coverage_file) };
+
+        if (!output.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open coverage file \"" << coverage_file << "\" for writing.";
+            throw File_Open_Failure(message.str());
+        }
+
+        const std::vector<Line_Table::Row> rows { lines.get_rows() };
+
+        output << g_coverage_header << ' ' << g_coverage_version << '\n' << m_code_size << ' ' << m_code_hash << '\n';
+
+        // Lines of 0 are unknown.
+        for (const int address : m_instructions) {
+            output
+                << address << ' ' << Line_Table::find(rows, address).line << ' '
+                << is_executed(address) << ' '
+                << ((m_is_branch[address] != 0) && is_taken(address)) << ' '
+                << ((m_is_branch[address] != 0) && fell_through(address)) << '\n';
+        }
+    }
+
+    void Coverage::print_summary(std::ostream& output, const Line_Table& lines) const {
+        const std::vector<Line_Table::Row> rows { lines.get_rows() };
+        std::size_t executed {};
+        std::size_t branch_directions {};
+        std::size_t branch_directions_taken {};
+        std::set<int> run_lines {};
+        std::set<int> unrun_lines {};
+
+        for (const int address : m_instructions) {
+            const int line { Line_Table::find(rows, address).line };
+
+            if (is_executed(address)) {
+                ++executed;
+                run_lines.insert(line);
+            }
+            else {
+                unrun_lines.insert(line);
+            }
+
+            if (m_is_branch[address] != 0) {
+                branch_directions += 2;
+                branch_directions_taken += static_cast<std::size_t>(is_taken(address)) + static_cast<std::size_t>(fell_through(address));
+            }
+        }
+
+        output
+            << "Coverage: " << std::fixed << std::setprecision(2)
+            << executed << " of " << m_instructions.size() << " instructions ("
+            << get_percentage(executed, m_instructions.size()) << "%), "
+            << branch_directions_taken << " of " << branch_directions << " branch directions ("
+            << get_percentage(branch_directions_taken, branch_directions) << "%)\n";
+
+        output.unsetf(std::ios::floatfield);
+
+        // Lines with any instruction that ran count as run. Unknown lines are left out.
+        for (const int line : run_lines) {
+            unrun_lines.erase(line);
+        }
+
+        unrun_lines.erase(0);
+
+        if (!unrun_lines.empty()) {
+            output << "    Lines never run: ";
+            print_line_ranges(output, unrun_lines);
+            output << '\n';
+        }
+
+        for (const int address : m_instructions) {
+            if ((m_is_branch[address] == 0) || !is_executed(address) || (is_taken(address) && fell_through(address))) {
+                continue;
+            }
+
+            output << "    Branch at index " << address;
+
+            const Source_Location location { Line_Table::find(rows, address) };
+
+            if (location.is_known()) {
+                output << " (line " << location.line << ')';
+            }
+
+            output << (is_taken(address) ? " never fell through\n" : " was never taken\n");
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "line_table.h"
+
+namespace svim {
+    // Records which instructions ran and which ways each conditional branch went in a map of one byte per address,
+    //     which Virtual_Machine writes into directly, so recording is a plain store with nothing to count or format.
+    // An instruction's byte is set once it runs. A conditional branch's directions go in the byte of its operand,
+    //     which is never the start of an instruction.
+    // Coverage files are bound to the bytecode they were recorded from, like Execution_Profile,
+    //     and name the source line of every instruction so they can be read without the program at hand.
+    class Coverage final {
+    public:
+        inline static constexpr std::uint8_t s_executed { 1 << 0 };
+        inline static constexpr std::uint8_t s_taken { 1 << 0 };
+        inline static constexpr std::uint8_t s_fell_through { 1 << 1 };
+
+        Coverage() = default;
+
+        // Clears everything recorded and binds the coverage to [bytecode].
+        void reset(const std::vector<int>& bytecode);
+
+        // Holds one byte per address of the bytecode given to reset().
+        std::uint8_t* get_map() { return m_map.data(); }
+
+        // Adds whatever [coverage_file] recorded for the same bytecode to ours, then saves the union back into it,
+        //     naming lines through [lines].
+        // Returns false if [coverage_file] was recorded from different bytecode, in which case it is replaced.
+        bool merge_into(std::string_view coverage_file, const Line_Table& lines);
+        // Prints how much of the program and its branches ran, then the lines and branch directions that never did.
+        void print_summary(std::ostream& output, const Line_Table& lines) const;
+
+        Coverage(const Coverage& other) = delete;
+        Coverage& operator =(const Coverage& other) = delete;
+
+    private:
+        std::size_t m_code_size {};
+        std::uint64_t m_code_hash {};
+        // Where every instruction starts, in order.
+        std::vector<int> m_instructions {};
+        std::vector<std::uint8_t> m_is_branch {};
+        std::vector<std::uint8_t> m_map {};
+
+        bool is_executed(int address) const { return (m_map[address] & s_executed) != 0; }
+        bool is_taken(int address) const { return (m_map[address + 1] & s_taken) != 0; }
+        bool fell_through(int address) const { return (m_map[address + 1] & s_fell_through) != 0; }
+
+        bool load(std::string_view coverage_file);
+        void save(std::string_view coverage_file, const Line_Table& lines) const;
+    };
+}
@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "execution_profile.h"
+#include "common/error.h"
+
+namespace svim {
+    //----------- Internal Data
+
+    static constexpr std::string_view g_profile_header { "svim-profile" };
+    static constexpr int g_profile_version { 1 };
+
+
+    //----------- Execution_Profile
+
+    Execution_Profile Execution_Profile::load(std::string_view profile_file) {
+        std::ifstream input { std::string(profile_file) };
+
+        if (!input.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open profile \"" << profile_file << ".\"";
+            throw File_Open_Failure(message.str());
+        }
+
+        std::string header {};
+        int version {};
+        Execution_Profile profile {};
+
+        input >> header >> version >> profile.m_code_size >> profile.m_code_hash;
+
+        if (!input || (header != g_profile_header) || (version != g_profile_version)) {
+            std::ostringstream message {};
+            message << "File \"" << profile_file << "\" is not a SVIM execution profile.";
+            throw std::runtime_error(message.str());
+        }
+
+        profile.m_execution_counts.resize(profile.m_code_size);
+        profile.m_taken_counts.resize(profile.m_code_size);
+
+        std::size_t address {};
+        std::uint64_t executions {};
+        std::uint64_t taken {};
+
+        while (input >> address >> executions >> taken) {
+            if (address < profile.m_code_size) {
+                profile.m_execution_counts[address] = executions;
+                profile.m_taken_counts[address] = taken;
+            }
+        }
+
+        return profile;
+    }
+
+    void Execution_Profile::save(std::string_view profile_file) const {
+        std::ofstream output { std::string(profile_file) };
+
+        if (!output.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open profile \"" << profile_file << "\" for writing.";
+            throw File_Open_Failure(message.str());
+        }
+
+        output << g_profile_header << ' ' << g_profile_version << '\n' << m_code_size << ' ' << m_code_hash << '\n';
+
+        // Addresses that never ran are left out and read back as 0.
+        for (std::size_t address {}; address < m_code_size; ++address) {
+            if (m_execution_counts[address] != 0) {
+                output << address << ' ' << m_execution_counts[address] << ' ' << m_taken_counts[address] << '\n';
+            }
+        }
+    }
+
+    void Execution_Profile::reset(const std::vector<int>& bytecode) {
+        m_code_size = bytecode.size();
+        m_code_hash = hash(bytecode);
+        m_execution_counts.assign(m_code_size, 0);
+        m_taken_counts.assign(m_code_size, 0);
+    }
+
+    bool Execution_Profile::matches(const std::vector<int>& bytecode) const {
+        return (bytecode.size() == m_code_size) && (hash(bytecode) == m_code_hash);
+    }
+
+    std::uint64_t Execution_Profile::get_execution_count(int address) const {
+        return ((address >= 0) && (static_cast<std::size_t>(address) < m_code_size)) ? m_execution_counts[address] : 0;
+    }
+
+    std::uint64_t Execution_Profile::get_taken_count(int address) const {
+        return ((address >= 0) && (static_cast<std::size_t>(address) < m_code_size)) ? m_taken_counts[address] : 0;
+    }
+
+    // 64-bit FNV-1a over every bytecode value.
+    std::uint64_t Execution_Profile::hash(const std::vector<int>& bytecode) {
+        std::uint64_t result { 14695981039346656037ull };
+
+        for (const int value : bytecode) {
+            result ^= static_cast<std::uint32_t>(value);
+            result *= 1099511628211ull;
+        }
+
+        return result;
+    }
+}
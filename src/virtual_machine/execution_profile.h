@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <cstdint>
+
+namespace svim {
+    // Per-address execution counts gathered by Virtual_Machine in record mode and consumed by Optimizer's block layout.
+    // A profile only applies to the exact bytecode it was recorded from, which is checked through a fingerprint.
+    class Execution_Profile final {
+    public:
+        Execution_Profile() = default;
+
+        static Execution_Profile load(std::string_view profile_file);
+        void save(std::string_view profile_file) const;
+
+        // Clears all counts and binds the profile to [bytecode].
+        void reset(const std::vector<int>& bytecode);
+        bool matches(const std::vector<int>& bytecode) const;
+
+        void record_execution(int address) { ++m_execution_counts[address]; }
+        void record_taken_branch(int address) { ++m_taken_counts[address]; }
+
+        std::uint64_t get_execution_count(int address) const;
+        std::uint64_t get_taken_count(int address) const;
+
+        // Fingerprint of [bytecode], for files that only apply to the bytecode they were recorded from.
+        static std::uint64_t hash(const std::vector<int>& bytecode);
+
+    private:
+        std::size_t m_code_size {};
+        std::uint64_t m_code_hash {};
+        std::vector<std::uint64_t> m_execution_counts {};
+        std::vector<std::uint64_t> m_taken_counts {};
+    };
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace svim {
+    // Counters gathered by Virtual_Machine while a program runs, for the "--stats" report.
+    struct Execution_Stats final {
+        // Includes tail calls.
+        std::uint64_t calls {};
+        // Both are measured between instructions. The call depth includes the frame the program starts in.
+        std::size_t peak_stack_depth {};
+        std::size_t peak_call_depth {};
+    };
+}
@@ -44,7 +44,19 @@ namespace svim {
                     //     and jumps to the destination address.
                     //     NOTE: For function calls, this instruction expects the function's arguments to be pushed onto the stack before using it.
         ret,        // Pops the current call frame and returns to the last jump point. Any new values on the stack are considered return values.
-        exit        // Exit program.
+        exit,       // Exit program.
+
+        // Internal instructions. These are only emitted by Optimizer and cannot be written in source code.
+        tcall,      // Same operands as "call," but reuses the current call frame instead of pushing a new one.
+                    //     NOTE: Only valid where a "call" would have been immediately followed by a "ret."
+        shl,        // Multiplies the top value of the stack by 2 raised to the following integer.
+        divp2,      // Divides the top value of the stack by 2 raised to the following integer, rounding toward 0 like "div."
+        modp2,      // Replaces the top value of the stack with its remainder from dividing by 2 raised to the following integer.
+        divm,       // Divides the top value of the stack by the following divisor, using the magic number and shift after it.
+        modm,       // Replaces the top value of the stack with its remainder from the following divisor,
+                    //     using the magic number and shift after it.
+        trap        // Written over an instruction by Virtual_Machine to mark a tracepoint. Logs the machine's state,
+                    //     then runs the instruction it replaced. Never appears in bytecode outside of the virtual machine.
     };
 
     // These values are here because we use them for our error-checking in Parser and, especially, Virtual_Machine.
@@ -81,15 +93,24 @@ namespace svim {
     inline constexpr std::string_view g_call                    { "CALL" };
     inline constexpr std::string_view g_ret                     { "RET" };
     inline constexpr std::string_view g_exit                    { "EXIT" };
+    inline constexpr std::string_view g_tail_call               { "TCALL" };
+    inline constexpr std::string_view g_shift_left              { "SHL" };
+    inline constexpr std::string_view g_div_power_of_two        { "DIVP2" };
+    inline constexpr std::string_view g_mod_power_of_two        { "MODP2" };
+    inline constexpr std::string_view g_div_magic               { "DIVM" };
+    inline constexpr std::string_view g_mod_magic               { "MODM" };
+    inline constexpr std::string_view g_trap                    { "TRAP" };
 
     struct Instruction_Data {
         std::string_view name {};
         Instruction value {};
         // This counts how many bytecode values beyond the current instruction we expect for [this.value].
         int expected_following_values {};
+        // Internal instructions are rejected by Parser.
+        bool internal {};
     };
 
-    inline constexpr std::array<const Instruction_Data, 33> g_instruction_data { {
+    inline constexpr std::array<const Instruction_Data, 40> g_instruction_data { {
         { g_add, Instruction::add, 0 },
         { g_sub, Instruction::sub, 0 },
         { g_mul, Instruction::mul, 0 },
@@ -129,6 +150,14 @@ namespace svim {
         { g_halt, Instruction::halt, 0 },
         { g_call, Instruction::call, 2 },
         { g_ret, Instruction::ret, 0 },
-        { g_exit, Instruction::exit, 0 }
+        { g_exit, Instruction::exit, 0 },
+
+        { g_tail_call, Instruction::tcall, 2, true },
+        { g_shift_left, Instruction::shl, 1, true },
+        { g_div_power_of_two, Instruction::divp2, 1, true },
+        { g_mod_power_of_two, Instruction::modp2, 1, true },
+        { g_div_magic, Instruction::divm, 3, true },
+        { g_mod_magic, Instruction::modm, 3, true },
+        { g_trap, Instruction::trap, 0, true }
     } };
 }
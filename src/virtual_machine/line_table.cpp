@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "line_table.h"
+
+#include <algorithm>
+
+namespace svim {
+    //----------- Internal Types
+
+    // Steps through encoded rows one at a time.
+    struct Row_Reader final {
+        const std::vector<std::uint8_t>& encoded;
+        std::size_t position {};
+        Line_Table::Row row {};
+
+        // Leaves [row] untouched if the bytes run out partway through a row.
+        bool next();
+    };
+
+
+    //----------- Helper Functions
+
+    // Seven bits per byte, lowest first, with the top bit set on every byte but the last.
+    static void write_varint(std::vector<std::uint8_t>& output, std::uint32_t value) {
+        while (value >= 0x80) {
+            output.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+
+        output.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    static bool read_varint(const std::vector<std::uint8_t>& input, std::size_t& position, std::uint32_t& value) {
+        value = 0;
+
+        for (int shift {}; (shift < 32) && (position < input.size()); shift += 7) {
+            const std::uint8_t byte { input[position++] };
+            value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Folds the sign into the lowest bit so small negative differences stay small.
+    static std::uint32_t zigzag_encode(int value) {
+        return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+    }
+
+    static int zigzag_decode(std::uint32_t value) {
+        return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+    }
+
+    bool Row_Reader::next() {
+        std::uint32_t address_delta {};
+        std::uint32_t line_delta {};
+        std::uint32_t column {};
+
+        if (!read_varint(encoded, position, address_delta) ||
+            !read_varint(encoded, position, line_delta) ||
+            !read_varint(encoded, position, column)) {
+            return false;
+        }
+
+        row.address += static_cast<int>(address_delta);
+        row.location.line += zigzag_decode(line_delta);
+        row.location.column = static_cast<int>(column);
+        return true;
+    }
+
+
+    //----------- Line_Table
+
+    Line_Table::Line_Table(std::vector<std::uint8_t>&& encoded) : m_encoded { std::move(encoded) } {
+        Row_Reader reader { m_encoded };
+
+        while (reader.next()) {}
+
+        // Anything after the last whole row is dropped, so rows added later still decode.
+        m_encoded.resize(reader.position);
+        m_last_row = reader.row;
+    }
+
+    void Line_Table::add(int address, Source_Location location) {
+        const bool is_first_row { m_encoded.empty() };
+
+        if (!is_first_row &&
+            ((address < m_last_row.address) ||
+             ((location.line == m_last_row.location.line) && (location.column == m_last_row.location.column)))) {
+            return;
+        }
+
+        write_varint(m_encoded, static_cast<std::uint32_t>(address - m_last_row.address));
+        write_varint(m_encoded, zigzag_encode(location.line - m_last_row.location.line));
+        write_varint(m_encoded, static_cast<std::uint32_t>(location.column));
+
+        m_last_row = { address, location };
+    }
+
+    Source_Location Line_Table::find(int address) const {
+        Row_Reader reader { m_encoded };
+        Source_Location found {};
+
+        while (reader.next() && (reader.row.address <= address)) {
+            found = reader.row.location;
+        }
+
+        return found;
+    }
+
+    std::vector<Line_Table::Row> Line_Table::get_rows() const {
+        std::vector<Row> rows {};
+        Row_Reader reader { m_encoded };
+
+        while (reader.next()) {
+            rows.push_back(reader.row);
+        }
+
+        return rows;
+    }
+
+    Source_Location Line_Table::find(const std::vector<Row>& rows, int address) {
+        const auto row {
+            std::upper_bound(rows.begin(), rows.end(), address, [](int target, const Row& row) {
+                return target < row.address;
+            })
+        };
+
+        return (row != rows.begin()) ? std::prev(row)->location : Source_Location {};
+    }
+}
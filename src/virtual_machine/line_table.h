@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace svim {
+    // Where in a ".svim" file an instruction came from. Both are counted from 1; a line of 0 means unknown.
+    struct Source_Location final {
+        int line {};
+        int column {};
+
+        bool is_known() const { return line > 0; }
+    };
+
+
+    // Maps bytecode addresses to the source locations they were parsed from.
+    // A row is only stored where the location changes, and every row is stored as differences from the last,
+    //     in the manner of DWARF line programs, so most rows take three bytes.
+    // Lookups decode from the start, so this belongs on cold paths only: errors, reports, and traces.
+    class Line_Table final {
+    public:
+        struct Row {
+            // Covers every address from here up to the next row's address.
+            int address {};
+            Source_Location location {};
+        };
+
+        Line_Table() = default;
+        // Takes bytes given by get_encoded(), such as ones read back from a file.
+        explicit Line_Table(std::vector<std::uint8_t>&& encoded);
+
+        // Rows must be added in increasing address order.
+        void add(int address, Source_Location location);
+
+        Source_Location find(int address) const;
+        std::vector<Row> get_rows() const;
+        // Searches rows given by get_rows(), for looking up many addresses without decoding each time.
+        static Source_Location find(const std::vector<Row>& rows, int address);
+
+        bool empty() const { return m_encoded.empty(); }
+        const std::vector<std::uint8_t>& get_encoded() const { return m_encoded; }
+
+    private:
+        std::vector<std::uint8_t> m_encoded {};
+        // The last row added, which the next is encoded against.
+        Row m_last_row {};
+    };
+}
@@ -0,0 +1,260 @@
+#include "pch.h"
+#include "live_metrics.h"
+#include "common/error.h"
+#include "common/timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <new>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace svim {
+    //----------- Internal Types
+
+    // Laid out in the shared file. Only lock-free atomics are shared between processes.
+    struct Live_Metrics_Block final {
+        char magic[8] {};
+        std::uint32_t version {};
+        std::uint32_t interval_milliseconds {};
+        std::int64_t process_id {};
+
+        std::atomic<std::uint64_t> instructions_retired {};
+        std::atomic<std::uint64_t> stack_depth {};
+        std::atomic<std::uint64_t> peak_stack_depth {};
+        std::atomic<std::uint64_t> call_depth {};
+        std::atomic<std::uint64_t> output_bytes {};
+        std::atomic<std::int64_t> instruction_index {};
+        std::atomic<std::uint64_t> publish_count {};
+        std::atomic<std::uint32_t> finished {};
+    };
+
+
+    //----------- Internal Data
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+    static_assert(std::atomic<std::int64_t>::is_always_lock_free);
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+    static constexpr char g_metrics_magic[8] { 's', 'v', 'i', 'm', 'l', 'i', 'v', 'e' };
+    static constexpr std::uint32_t g_metrics_version { 1 };
+    static constexpr std::string_view g_shared_memory_directory { "/dev/shm/" };
+
+
+    //----------- Helper Functions
+
+    static std::string get_metrics_path(std::string_view name) {
+        if (name.find('/') != std::string_view::npos) {
+            return std::string(name);
+        }
+
+        return std::string(g_shared_memory_directory) + std::string(name);
+    }
+
+#if !defined(_WIN32)
+    static bool is_process_running(std::int64_t process_id) {
+        return (::kill(static_cast<pid_t>(process_id), 0) == 0) || (errno != ESRCH);
+    }
+#endif
+
+
+    //----------- Live_Metrics
+
+#if defined(_WIN32)
+    Live_Metrics::Live_Metrics(std::string_view name, int interval_milliseconds) {
+        throw std::runtime_error("Live metrics need POSIX shared memory files, which this platform does not have.");
+    }
+
+    Live_Metrics::~Live_Metrics() {}
+
+    void Live_Metrics::start(std::atomic<unsigned int>& flags, unsigned int flag) {}
+
+    void Live_Metrics::stop() {}
+
+    void Live_Metrics::publish(const Snapshot& snapshot) {}
+
+    void Live_Metrics::finish() {}
+
+    void Live_Metrics::watch(std::string_view name, std::ostream& output) {
+        throw std::runtime_error("Live metrics need POSIX shared memory files, which this platform does not have.");
+    }
+#else
+    Live_Metrics::Live_Metrics(std::string_view name, int interval_milliseconds) :
+        m_path { get_metrics_path(name) },
+        m_interval_milliseconds { (interval_milliseconds > 0) ? interval_milliseconds : 1 }
+    {
+        const int descriptor { ::open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) };
+
+        if (descriptor < 0) {
+            std::ostringstream message {};
+            message << "Could not create live metrics file \"" << m_path << ".\"";
+            throw File_Open_Failure(message.str());
+        }
+
+        void* memory { MAP_FAILED };
+
+        if (::ftruncate(descriptor, sizeof(Live_Metrics_Block)) == 0) {
+            memory = ::mmap(nullptr, sizeof(Live_Metrics_Block), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        }
+
+        ::close(descriptor);
+
+        if (memory == MAP_FAILED) {
+            ::unlink(m_path.c_str());
+            std::ostringstream message {};
+            message << "Could not map live metrics file \"" << m_path << ".\"";
+            throw std::runtime_error(message.str());
+        }
+
+        m_block = new (memory) Live_Metrics_Block {};
+        m_block->version = g_metrics_version;
+        m_block->interval_milliseconds = static_cast<std::uint32_t>(m_interval_milliseconds);
+        m_block->process_id = static_cast<std::int64_t>(::getpid());
+
+        // Written last, so readers never take a half-made file for a valid one.
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(m_block->magic, g_metrics_magic, sizeof(m_block->magic));
+    }
+
+    Live_Metrics::~Live_Metrics() {
+        finish();
+        ::munmap(m_block, sizeof(Live_Metrics_Block));
+        ::unlink(m_path.c_str());
+    }
+
+    void Live_Metrics::start(std::atomic<unsigned int>& flags, unsigned int flag) {
+        if (m_thread.joinable()) {
+            return;
+        }
+
+        m_stopping.store(false);
+
+        m_thread = std::thread([this, &flags, flag]() {
+            std::unique_lock<std::mutex> lock { m_wait_mutex };
+            const std::chrono::milliseconds interval { m_interval_milliseconds };
+
+            while (!m_wake.wait_for(lock, interval, [this]() { return m_stopping.load(); })) {
+                flags.fetch_or(flag, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    void Live_Metrics::stop() {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock { m_wait_mutex };
+            m_stopping.store(true);
+        }
+
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    void Live_Metrics::publish(const Snapshot& snapshot) {
+        m_peak_stack_depth = std::max(m_peak_stack_depth, snapshot.stack_depth);
+
+        m_block->instructions_retired.store(snapshot.instructions_retired, std::memory_order_relaxed);
+        m_block->stack_depth.store(snapshot.stack_depth, std::memory_order_relaxed);
+        m_block->peak_stack_depth.store(m_peak_stack_depth, std::memory_order_relaxed);
+        m_block->call_depth.store(snapshot.call_depth, std::memory_order_relaxed);
+        m_block->output_bytes.store(snapshot.output_bytes, std::memory_order_relaxed);
+        m_block->instruction_index.store(snapshot.instruction_index, std::memory_order_relaxed);
+        m_block->publish_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Live_Metrics::finish() {
+        stop();
+        m_block->finished.store(1, std::memory_order_release);
+    }
+
+    void Live_Metrics::watch(std::string_view name, std::ostream& output) {
+        const std::string path { get_metrics_path(name) };
+        const int descriptor { ::open(path.c_str(), O_RDONLY) };
+
+        if (descriptor < 0) {
+            std::ostringstream message {};
+            message << "No live metrics are being published at \"" << path << ".\"";
+            throw File_Open_Failure(message.str());
+        }
+
+        struct stat status {};
+        void* memory { MAP_FAILED };
+
+        if ((::fstat(descriptor, &status) == 0) && (static_cast<std::size_t>(status.st_size) >= sizeof(Live_Metrics_Block))) {
+            memory = ::mmap(nullptr, sizeof(Live_Metrics_Block), PROT_READ, MAP_SHARED, descriptor, 0);
+        }
+
+        ::close(descriptor);
+
+        if (memory == MAP_FAILED) {
+            std::ostringstream message {};
+            message << "File \"" << path << "\" does not hold SVIM live metrics.";
+            throw std::runtime_error(message.str());
+        }
+
+        const Live_Metrics_Block& block { *static_cast<const Live_Metrics_Block*>(memory) };
+
+        if ((std::memcmp(block.magic, g_metrics_magic, sizeof(block.magic)) != 0) || (block.version != g_metrics_version)) {
+            ::munmap(memory, sizeof(Live_Metrics_Block));
+            std::ostringstream message {};
+            message << "File \"" << path << "\" does not hold SVIM live metrics from this version.";
+            throw std::runtime_error(message.str());
+        }
+
+        output
+            << "Watching process " << block.process_id << " through \"" << path << "\"\n"
+            << std::setw(16) << "Instructions" << std::setw(12) << "M instr/s" << std::setw(10) << "Index"
+            << std::setw(10) << "Stack" << std::setw(12) << "Peak stack" << std::setw(10) << "Calls"
+            << std::setw(16) << "Output bytes" << '\n';
+
+        const std::chrono::milliseconds interval { std::max<std::uint32_t>(block.interval_milliseconds, 1) };
+        std::uint64_t last_instructions { block.instructions_retired.load(std::memory_order_relaxed) };
+        Time_Point last_time { get_current_time() };
+
+        while (true) {
+            const bool finished { block.finished.load(std::memory_order_acquire) != 0 };
+            const std::uint64_t instructions { block.instructions_retired.load(std::memory_order_relaxed) };
+            const Time_Point now { get_current_time() };
+            const std::int64_t elapsed { get_elapsed_nanoseconds(last_time, now) };
+            const double rate { (elapsed > 0) ? (static_cast<double>(instructions - last_instructions) * 1e3 / static_cast<double>(elapsed)) : 0.0 };
+
+            output
+                << std::setw(16) << instructions
+                << std::setw(12) << std::fixed << std::setprecision(1) << rate
+                << std::setw(10) << block.instruction_index.load(std::memory_order_relaxed)
+                << std::setw(10) << block.stack_depth.load(std::memory_order_relaxed)
+                << std::setw(12) << block.peak_stack_depth.load(std::memory_order_relaxed)
+                << std::setw(10) << block.call_depth.load(std::memory_order_relaxed)
+                << std::setw(16) << block.output_bytes.load(std::memory_order_relaxed) << '\n' << std::flush;
+
+            if (finished) {
+                output << "Program finished.\n";
+                break;
+            }
+
+            if (!is_process_running(block.process_id)) {
+                output << "Program ended without finishing its metrics.\n";
+                break;
+            }
+
+            last_instructions = instructions;
+            last_time = now;
+            std::this_thread::sleep_for(interval);
+        }
+
+        output.unsetf(std::ios::floatfield);
+        ::munmap(memory, sizeof(Live_Metrics_Block));
+    }
+#endif
+}
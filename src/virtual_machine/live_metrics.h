@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace svim {
+    struct Live_Metrics_Block;
+
+    // Publishes a running VM's counters into a small shared memory file, which watch() can display
+    //     from another process while the program runs.
+    // A background thread raises a flag every interval, and Virtual_Machine publishes at its next instruction,
+    //     so nothing is counted or compared between publishes. Counters are written with relaxed atomic stores;
+    //     readers only ever see whole values, though not necessarily all from the same instant.
+    // Names without a '/' are placed in "/dev/shm." Where files cannot be mapped, the constructor throws.
+    class Live_Metrics final {
+    public:
+        struct Snapshot {
+            std::uint64_t instructions_retired {};
+            std::uint64_t stack_depth {};
+            std::uint64_t call_depth {};
+            std::uint64_t output_bytes {};
+            std::int64_t instruction_index {};
+        };
+
+        // Creates the file for [name], replacing any left behind by an earlier run.
+        Live_Metrics(std::string_view name, int interval_milliseconds);
+        // Marks the metrics finished and removes the file. Readers that already have it open can still see the end.
+        ~Live_Metrics();
+
+        // Starts the thread that sets [flag] in [flags] every interval.
+        void start(std::atomic<unsigned int>& flags, unsigned int flag);
+        void stop();
+
+        void publish(const Snapshot& snapshot);
+        // Stops the thread and tells readers no more updates are coming.
+        void finish();
+
+        // Prints the metrics published under [name] every interval until the program publishing them ends.
+        // Throws File_Open_Failure if nothing is published under [name].
+        static void watch(std::string_view name, std::ostream& output);
+
+        Live_Metrics(const Live_Metrics& other) = delete;
+        Live_Metrics& operator =(const Live_Metrics& other) = delete;
+
+    private:
+        std::string m_path {};
+        int m_interval_milliseconds {};
+        Live_Metrics_Block* m_block {};
+        // The deepest stack seen by any publish, so short spikes between publishes go unseen.
+        std::uint64_t m_peak_stack_depth {};
+
+        std::atomic<bool> m_stopping {};
+        std::mutex m_wait_mutex {};
+        std::condition_variable m_wake {};
+        std::thread m_thread {};
+    };
+}
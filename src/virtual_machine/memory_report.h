@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace svim {
+    // Memory one Virtual_Machine holds, for the "--stats" report and for sizing machines to pack onto a host.
+    // Containers are counted by the capacity they reserved rather than by what is in use.
+    // Peak stack and call depths are in Execution_Stats, as they are only counted while it is recording.
+    struct Memory_Report final {
+        // The Virtual_Machine object itself, apart from what it points to.
+        std::size_t machine_bytes {};
+        std::size_t code_bytes {};
+        std::size_t stack_capacity {};
+        std::size_t stack_bytes {};
+        std::size_t call_stack_capacity {};
+        std::size_t call_stack_bytes {};
+        std::size_t global_values {};
+        std::size_t global_bytes {};
+        // One past the highest global index any "GPUSH" or "GSTORE" in the code names, or 0 if none do.
+        std::size_t globals_referenced {};
+        // The logger's output buffer, along with any ring or mapped window its writer keeps.
+        std::size_t output_buffer_bytes {};
+        // Coverage marks, tracepoints, and sampling scratch space kept by the machine itself.
+        //     Instrumentation given to the machine, such as a Trace_Buffer, is owned and counted elsewhere.
+        std::size_t instrumentation_bytes {};
+
+        std::size_t get_total_bytes() const {
+            return machine_bytes + code_bytes + stack_bytes + call_stack_bytes + global_bytes + output_buffer_bytes + instrumentation_bytes;
+        }
+    };
+}
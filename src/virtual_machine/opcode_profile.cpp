@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "opcode_profile.h"
+#include "common/error.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+namespace svim {
+    //----------- Internal Types
+
+    // A run of 1 to 3 opcodes, named like "LPUSH PUSH LT."
+    struct Opcode_Sequence final {
+        std::size_t length {};
+        std::string names {};
+        std::uint64_t count {};
+    };
+
+
+    //----------- Internal Data
+
+    static constexpr std::string_view g_opcode_profile_header { "svim-opcode-profile" };
+    static constexpr int g_opcode_profile_version { 1 };
+    static constexpr std::size_t g_max_sequence_length { 3 };
+    static constexpr std::string_view g_sequence_titles[g_max_sequence_length] { "Opcodes", "Pairs", "Triples" };
+
+
+    //----------- Helper Functions
+
+    // [counts] is indexed by [length] opcodes as digits in base [slots], the first opcode being the most significant.
+    //     The highest digit stands for "no instruction," and sequences containing it are skipped.
+    static void collect_sequences(const std::vector<std::uint64_t>& counts, std::size_t length, std::size_t slots,
+                                  std::vector<Opcode_Sequence>& sequences) {
+        const std::size_t none { slots - 1 };
+
+        for (std::size_t index {}; index < counts.size(); ++index) {
+            if (counts[index] == 0) {
+                continue;
+            }
+
+            std::size_t op_codes[g_max_sequence_length] {};
+            std::size_t remaining { index };
+            bool complete { true };
+
+            for (std::size_t i { length }; i > 0; --i) {
+                op_codes[i - 1] = remaining % slots;
+                remaining /= slots;
+                complete = complete && (op_codes[i - 1] != none);
+            }
+
+            if (!complete) {
+                continue;
+            }
+
+            Opcode_Sequence sequence { length, {}, counts[index] };
+
+            for (std::size_t i {}; i < length; ++i) {
+                if (i > 0) {
+                    sequence.names += ' ';
+                }
+
+                sequence.names += g_instruction_data[op_codes[i]].name;
+            }
+
+            sequences.push_back(std::move(sequence));
+        }
+    }
+
+    // Shortest sequences first, then most frequent first.
+    static void sort_sequences(std::vector<Opcode_Sequence>& sequences) {
+        std::sort(sequences.begin(), sequences.end(), [](const Opcode_Sequence& a, const Opcode_Sequence& b) {
+            if (a.length != b.length) {
+                return a.length < b.length;
+            }
+
+            if (a.count != b.count) {
+                return a.count > b.count;
+            }
+
+            return a.names < b.names;
+        });
+    }
+
+    static void load_sequences(std::string_view profile_file, std::map<std::pair<std::size_t, std::string>, std::uint64_t>& totals) {
+        std::ifstream input { std::string(profile_file) };
+
+        // Nothing has been recorded into it yet.
+        if (!input.is_open()) {
+            return;
+        }
+
+        std::string header {};
+        int version {};
+        input >> header >> version;
+
+        if (!input || (header != g_opcode_profile_header) || (version != g_opcode_profile_version)) {
+            std::ostringstream message {};
+            message << "File \"" << profile_file << "\" is not a SVIM opcode profile.";
+            throw std::runtime_error(message.str());
+        }
+
+        std::size_t length {};
+        std::uint64_t count {};
+        std::string names {};
+
+        while ((input >> length >> count) && std::getline(input >> std::ws, names)) {
+            if ((length > 0) && (length <= g_max_sequence_length)) {
+                totals[{ length, names }] += count;
+            }
+        }
+    }
+
+
+    //----------- Opcode_Profile
+
+    Opcode_Profile::Opcode_Profile() :
+        m_counts(s_slots),
+        m_pair_counts(s_slots * s_slots),
+        m_triple_counts(s_slots * s_slots * s_slots) {}
+
+    void Opcode_Profile::merge_into(std::string_view profile_file) const {
+        std::map<std::pair<std::size_t, std::string>, std::uint64_t> totals {};
+        load_sequences(profile_file, totals);
+
+        std::vector<Opcode_Sequence> sequences {};
+        collect_sequences(m_counts, 1, s_slots, sequences);
+        collect_sequences(m_pair_counts, 2, s_slots, sequences);
+        collect_sequences(m_triple_counts, 3, s_slots, sequences);
+
+        for (const Opcode_Sequence& sequence : sequences) {
+            totals[{ sequence.length, sequence.names }] += sequence.count;
+        }
+
+        sequences.clear();
+
+        for (const auto& [key, count] : totals) {
+            sequences.push_back({ key.first, key.second, count });
+        }
+
+        sort_sequences(sequences);
+
+        std::ofstream output { std::string(profile_file) };
+
+        if (!output.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open opcode profile \"" << profile_file << "\" for writing.";
+            throw File_Open_Failure(message.str());
+        }
+
+        output << g_opcode_profile_header << ' ' << g_opcode_profile_version << '\n';
+
+        for (const Opcode_Sequence& sequence : sequences) {
+            output << sequence.length << ' ' << sequence.count << ' ' << sequence.names << '\n';
+        }
+    }
+
+    void Opcode_Profile::print_summary(std::ostream& output, std::size_t limit) const {
+        std::vector<Opcode_Sequence> sequences {};
+        collect_sequences(m_counts, 1, s_slots, sequences);
+        collect_sequences(m_pair_counts, 2, s_slots, sequences);
+        collect_sequences(m_triple_counts, 3, s_slots, sequences);
+        sort_sequences(sequences);
+
+        std::uint64_t total {};
+
+        for (std::uint64_t count : m_counts) {
+            total += count;
+        }
+
+        std::size_t printed {};
+        std::size_t length {};
+
+        for (const Opcode_Sequence& sequence : sequences) {
+            if (sequence.length != length) {
+                length = sequence.length;
+                printed = 0;
+                output << g_sequence_titles[length - 1] << ":\n";
+            }
+
+            if (printed++ >= limit) {
+                continue;
+            }
+
+            const double share { (total > 0) ? (100.0 * static_cast<double>(sequence.count) / static_cast<double>(total)) : 0.0 };
+
+            output
+                << "    " << std::setw(7) << std::fixed << std::setprecision(2) << share << "%  "
+                << std::setw(12) << sequence.count << "  " << sequence.names << '\n';
+        }
+
+        output.unsetf(std::ios::floatfield);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "instructions.h"
+
+namespace svim {
+    // Counts how often every opcode, and every run of 2 and 3 consecutive opcodes, executes.
+    // Profiles are saved by instruction name rather than by opcode value, so runs recorded
+    //     before the instruction set changed can still be merged.
+    class Opcode_Profile final {
+    public:
+        Opcode_Profile();
+
+        void record(int op_code) {
+            const std::size_t pair { (m_previous * s_slots) + static_cast<std::size_t>(op_code) };
+
+            ++m_counts[op_code];
+            ++m_pair_counts[pair];
+            ++m_triple_counts[(m_before_previous * s_slots * s_slots) + pair];
+
+            m_before_previous = m_previous;
+            m_previous = static_cast<std::size_t>(op_code);
+        }
+
+        // Adds the counts already in [profile_file], if it exists, to ours and saves the sum back into it.
+        void merge_into(std::string_view profile_file) const;
+        // Prints the [limit] most frequent opcodes, pairs, and triples.
+        void print_summary(std::ostream& output, std::size_t limit) const;
+
+        Opcode_Profile(const Opcode_Profile& other) = delete;
+        Opcode_Profile& operator =(const Opcode_Profile& other) = delete;
+
+    private:
+        // One slot per opcode, plus one standing in for "no instruction yet" at the start of a run.
+        inline static constexpr std::size_t s_slots { g_instruction_data.size() + 1 };
+        inline static constexpr std::size_t s_none { g_instruction_data.size() };
+
+        std::vector<std::uint64_t> m_counts {};
+        std::vector<std::uint64_t> m_pair_counts {};
+        std::vector<std::uint64_t> m_triple_counts {};
+        std::size_t m_previous { s_none };
+        std::size_t m_before_previous { s_none };
+    };
+}
@@ -0,0 +1,1686 @@
+#include "pch.h"
+#include "optimizer.h"
+#include "instructions.h"
+#include "virtual_machine.h"
+#include "common/debug.h"
+
+namespace svim {
+    //----------- Internal Types
+
+    // A value computed inside a loop, written in terms of the values locals held at the top of the loop.
+    struct Linear_Value final {
+        enum class Kind {
+            unknown,
+            constant,
+            local
+        };
+
+        Kind kind { Kind::unknown };
+        int local {};
+        long long offset {};
+
+        bool is_constant() const { return kind == Kind::constant; }
+        bool is_local() const { return kind == Kind::local; }
+    };
+
+    struct Symbol final {
+        static constexpr int s_no_comparison { -1 };
+
+        Linear_Value value {};
+        // If this symbol is the result of a comparison, [value] is its left side and [right] its right side.
+        int comparison { s_no_comparison };
+        Linear_Value right {};
+
+        bool is_comparison() const { return comparison != s_no_comparison; }
+    };
+
+    struct Symbolic_State final {
+        std::vector<Symbol> stack {};
+        std::array<Linear_Value, Virtual_Machine::get_max_local_values()> locals {};
+
+        // Values consumed from below the part of the stack we know about are unknown.
+        Symbol pop() {
+            if (stack.empty()) {
+                return {};
+            }
+
+            Symbol top { stack.back() };
+            stack.pop_back();
+            return top;
+        }
+
+        void push(Symbol symbol) { stack.push_back(symbol); }
+        void push(Linear_Value value) { stack.push_back({ value }); }
+    };
+
+
+    struct Basic_Block final {
+        static constexpr int s_none { -1 };
+        static constexpr int s_program_end { -2 };
+
+        std::size_t first {};
+        std::size_t last {};
+        // Successors are block indices, s_program_end for running off the end of the bytecode, or s_none.
+        int fall_through { s_none };
+        int target { s_none };
+        std::uint64_t executions {};
+        std::uint64_t fall_through_weight {};
+        std::uint64_t target_weight {};
+    };
+
+
+    // A call frame of a function being evaluated at optimization time.
+    struct Evaluation_Frame final {
+        std::size_t return_index {};
+        std::array<int, Virtual_Machine::get_max_local_values()> locals {};
+    };
+
+
+    //----------- Helper Functions
+
+    static bool is_valid_op_code(int op_code) {
+        return (op_code >= 0) && (op_code < static_cast<int>(g_instruction_data.size()));
+    }
+
+    static int get_operand_count(int op_code) {
+        return g_instruction_data[op_code].expected_following_values;
+    }
+
+    // Instructions whose first operand is a bytecode address.
+    static bool refers_to_address(int op_code) {
+        return (op_code == Instruction::br) ||
+            (op_code == Instruction::brt) ||
+            (op_code == Instruction::brf) ||
+            (op_code == Instruction::call) ||
+            (op_code == Instruction::tcall);
+    }
+
+    static bool is_branch(int op_code) {
+        return (op_code == Instruction::br) || (op_code == Instruction::brt) || (op_code == Instruction::brf);
+    }
+
+    // Instructions after which control never continues with the next instruction in the bytecode.
+    static bool ends_control_flow(int op_code) {
+        return (op_code == Instruction::br) ||
+            (op_code == Instruction::ret) ||
+            (op_code == Instruction::tcall) ||
+            (op_code == Instruction::exit);
+    }
+
+    // Gives the number of values [op_code] removes from and adds to the stack, if it is fixed.
+    static bool get_stack_effect(int op_code, int& pops, int& pushes) {
+        switch (op_code) {
+        case Instruction::add:
+        case Instruction::sub:
+        case Instruction::mul:
+        case Instruction::div:
+        case Instruction::mod:
+        case Instruction::lt:
+        case Instruction::gt:
+        case Instruction::eq:
+        case Instruction::leq:
+        case Instruction::geq:
+        case Instruction::neq:
+            pops = 2;
+            pushes = 1;
+            return true;
+
+        case Instruction::inc:
+        case Instruction::dec:
+        case Instruction::neg:
+        case Instruction::shl:
+        case Instruction::divp2:
+        case Instruction::modp2:
+        case Instruction::divm:
+        case Instruction::modm:
+            pops = 1;
+            pushes = 1;
+            return true;
+
+        case Instruction::push:
+        case Instruction::lpush:
+        case Instruction::gpush:
+            pops = 0;
+            pushes = 1;
+            return true;
+
+        case Instruction::lstore:
+        case Instruction::gstore:
+        case Instruction::print:
+        case Instruction::pop:
+            pops = 1;
+            pushes = 0;
+            return true;
+
+        case Instruction::dup:
+            pops = 1;
+            pushes = 2;
+            return true;
+
+        case Instruction::dup2:
+            pops = 2;
+            pushes = 4;
+            return true;
+
+        case Instruction::swap:
+            pops = 2;
+            pushes = 2;
+            return true;
+
+        case Instruction::over:
+            pops = 2;
+            pushes = 3;
+            return true;
+
+        case Instruction::turn:
+            pops = 3;
+            pushes = 3;
+            return true;
+
+        case Instruction::halt:
+            pops = 0;
+            pushes = 0;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // Pure instructions only touch the stack, so removing one (along with whatever consumes its results) is safe.
+    static bool is_pure(int op_code) {
+        int pops {};
+        int pushes {};
+
+        return get_stack_effect(op_code, pops, pushes) &&
+            (op_code != Instruction::div) &&
+            (op_code != Instruction::mod) &&
+            (op_code != Instruction::lstore) &&
+            (op_code != Instruction::gstore) &&
+            (op_code != Instruction::print) &&
+            (op_code != Instruction::halt);
+    }
+
+    // If operations [first, last) are all pure and leave exactly one new value on top of the stack
+    //     (after consuming [consumed] values from beneath them), returns true.
+    template <typename Operation_Iterator>
+    static bool computes_single_value(Operation_Iterator first, Operation_Iterator last, int& consumed) {
+        int depth {};
+        int lowest_depth {};
+
+        for (Operation_Iterator current { first }; current != last; ++current) {
+            int pops {};
+            int pushes {};
+
+            if (!is_pure(current->op_code) || !get_stack_effect(current->op_code, pops, pushes)) {
+                return false;
+            }
+
+            depth -= pops;
+            lowest_depth = (depth < lowest_depth) ? depth : lowest_depth;
+            depth += pushes;
+        }
+
+        consumed = -lowest_depth;
+        return (first != last) && (depth == (1 - consumed));
+    }
+
+    // Removes "DUP ... POP" pairs from straight-line operations [first, operations.end()) where everything in between
+    //     only works above the duplicated value, leaving the POP to discard the original instead of the copy.
+    template <typename Operation>
+    static void remove_discarded_duplicates(std::vector<Operation>& operations, std::size_t first) {
+        for (std::size_t duplicate { first }; duplicate < operations.size(); ++duplicate) {
+            if (operations[duplicate].op_code != Instruction::dup) {
+                continue;
+            }
+
+            // Depths count the original value and its copy, so reaching 1 means the copy has been consumed.
+            int depth { 2 };
+
+            for (std::size_t i { duplicate + 1 }; i < operations.size(); ++i) {
+                const int op_code { operations[i].op_code };
+                int pops {};
+                int pushes {};
+
+                if ((op_code == Instruction::pop) && (depth == 1)) {
+                    operations.erase(operations.begin() + i);
+                    operations.erase(operations.begin() + duplicate);
+                    --duplicate;
+                    break;
+                }
+
+                if (!get_stack_effect(op_code, pops, pushes) || ((depth - pops) < 1)) {
+                    break;
+                }
+
+                depth += pushes - pops;
+            }
+        }
+    }
+
+    static Linear_Value add_linear(Linear_Value a, Linear_Value b, bool subtract) {
+        const long long b_offset { (subtract) ? -b.offset : b.offset };
+
+        if (a.is_constant() && b.is_constant()) {
+            return { Linear_Value::Kind::constant, 0, a.offset + b_offset };
+        }
+
+        if (a.is_local() && b.is_constant()) {
+            return { Linear_Value::Kind::local, a.local, a.offset + b_offset };
+        }
+
+        if (!subtract && a.is_constant() && b.is_local()) {
+            return { Linear_Value::Kind::local, b.local, a.offset + b.offset };
+        }
+
+        return {};
+    }
+
+    static bool evaluate_symbolically(Symbolic_State& state, int op_code, int operand) {
+        switch (op_code) {
+        case Instruction::push:
+            state.push(Linear_Value { Linear_Value::Kind::constant, 0, operand });
+            return true;
+
+        case Instruction::lpush:
+            state.push(state.locals[operand]);
+            return true;
+
+        case Instruction::lstore:
+        {
+            Symbol stored { state.pop() };
+            state.locals[operand] = (stored.is_comparison()) ? Linear_Value {} : stored.value;
+            return true;
+        }
+
+        case Instruction::gpush:
+            state.push(Symbol {});
+            return true;
+
+        case Instruction::gstore:
+        case Instruction::print:
+        case Instruction::pop:
+            state.pop();
+            return true;
+
+        case Instruction::add:
+        case Instruction::sub:
+        {
+            Symbol b { state.pop() };
+            Symbol a { state.pop() };
+
+            if (a.is_comparison() || b.is_comparison()) {
+                state.push(Symbol {});
+            }
+            else {
+                state.push(add_linear(a.value, b.value, op_code == Instruction::sub));
+            }
+
+            return true;
+        }
+
+        case Instruction::inc:
+        case Instruction::dec:
+        {
+            Symbol a { state.pop() };
+            const Linear_Value one { Linear_Value::Kind::constant, 0, 1 };
+            state.push((a.is_comparison()) ? Symbol {} : Symbol { add_linear(a.value, one, op_code == Instruction::dec) });
+            return true;
+        }
+
+        case Instruction::neg:
+        {
+            Symbol a { state.pop() };
+            const bool foldable { !a.is_comparison() && a.value.is_constant() };
+            state.push((foldable) ? Symbol { { Linear_Value::Kind::constant, 0, -a.value.offset } } : Symbol {});
+            return true;
+        }
+
+        case Instruction::mul:
+        case Instruction::div:
+        case Instruction::mod:
+            state.pop();
+            state.pop();
+            state.push(Symbol {});
+            return true;
+
+        case Instruction::shl:
+        case Instruction::divp2:
+        case Instruction::modp2:
+        case Instruction::divm:
+        case Instruction::modm:
+            state.pop();
+            state.push(Symbol {});
+            return true;
+
+        case Instruction::lt:
+        case Instruction::gt:
+        case Instruction::eq:
+        case Instruction::leq:
+        case Instruction::geq:
+        case Instruction::neq:
+        {
+            Symbol b { state.pop() };
+            Symbol a { state.pop() };
+
+            if (a.is_comparison() || b.is_comparison()) {
+                state.push(Symbol {});
+            }
+            else {
+                state.push(Symbol { a.value, op_code, b.value });
+            }
+
+            return true;
+        }
+
+        case Instruction::dup:
+        {
+            Symbol a { state.pop() };
+            state.push(a);
+            state.push(a);
+            return true;
+        }
+
+        case Instruction::dup2:
+        {
+            Symbol b { state.pop() };
+            Symbol a { state.pop() };
+            state.push(a);
+            state.push(b);
+            state.push(a);
+            state.push(b);
+            return true;
+        }
+
+        case Instruction::swap:
+        {
+            Symbol b { state.pop() };
+            Symbol a { state.pop() };
+            state.push(b);
+            state.push(a);
+            return true;
+        }
+
+        case Instruction::over:
+        {
+            Symbol b { state.pop() };
+            Symbol a { state.pop() };
+            state.push(a);
+            state.push(b);
+            state.push(a);
+            return true;
+        }
+
+        case Instruction::turn:
+        {
+            Symbol c { state.pop() };
+            Symbol b { state.pop() };
+            Symbol a { state.pop() };
+            state.push(b);
+            state.push(c);
+            state.push(a);
+            return true;
+        }
+
+        case Instruction::halt:
+            return true;
+
+        // Callees cannot touch our locals, but we lose track of how many values they leave on the stack.
+        case Instruction::call:
+            state.stack.clear();
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // Comparison giving the same result with its sides swapped.
+    static int mirror_comparison(int comparison) {
+        switch (comparison) {
+        case Instruction::lt: return Instruction::gt;
+        case Instruction::gt: return Instruction::lt;
+        case Instruction::leq: return Instruction::geq;
+        case Instruction::geq: return Instruction::leq;
+        default: return comparison;
+        }
+    }
+
+    // Comparison giving the opposite result.
+    static int negate_comparison(int comparison) {
+        switch (comparison) {
+        case Instruction::lt: return Instruction::geq;
+        case Instruction::gt: return Instruction::leq;
+        case Instruction::leq: return Instruction::gt;
+        case Instruction::geq: return Instruction::lt;
+        case Instruction::eq: return Instruction::neq;
+        case Instruction::neq: return Instruction::eq;
+        default: return comparison;
+        }
+    }
+
+    // Integer arithmetic wraps around the way it does on the machines Virtual_Machine runs on.
+    static int wrap_to_int(long long value) {
+        return static_cast<int>(static_cast<unsigned int>(value));
+    }
+
+    // Applies a two-operand arithmetic or comparison instruction. Division by 0 or overflowing division fails.
+    static bool evaluate_binary_operation(int op_code, int a, int b, int& result) {
+        const long long wide_a { a };
+        const long long wide_b { b };
+
+        switch (op_code) {
+        case Instruction::add: result = wrap_to_int(wide_a + wide_b); return true;
+        case Instruction::sub: result = wrap_to_int(wide_a - wide_b); return true;
+        case Instruction::mul: result = wrap_to_int(wide_a * wide_b); return true;
+        case Instruction::lt: result = (a < b) ? 1 : 0; return true;
+        case Instruction::gt: result = (a > b) ? 1 : 0; return true;
+        case Instruction::eq: result = (a == b) ? 1 : 0; return true;
+        case Instruction::leq: result = (a <= b) ? 1 : 0; return true;
+        case Instruction::geq: result = (a >= b) ? 1 : 0; return true;
+        case Instruction::neq: result = (a != b) ? 1 : 0; return true;
+
+        case Instruction::div:
+        case Instruction::mod:
+            if ((b == 0) || ((a == std::numeric_limits<int>::min()) && (b == -1))) {
+                return false;
+            }
+
+            result = (op_code == Instruction::div) ? (a / b) : (a % b);
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    static bool fits_in_operand(long long value) {
+        return (value >= std::numeric_limits<int>::min()) && (value <= std::numeric_limits<int>::max());
+    }
+
+
+    // Returns the exponent if [value] is a power of 2 greater than 1; else, 0.
+    static int get_power_of_two(long long value) {
+        if ((value < 2) || ((value & (value - 1)) != 0)) {
+            return 0;
+        }
+
+        int exponent {};
+
+        while (value > 1) {
+            value >>= 1;
+            ++exponent;
+        }
+
+        return exponent;
+    }
+
+    // Finds [magic] and [shift] such that "n / divisor" equals the high half of "magic * n," corrected for sign and shifted.
+    // [divisor] must not be -1, 0, 1, or the lowest 32-bit integer. ("Hacker's Delight," Figure 10-1.)
+    static void compute_division_magic(int divisor, int& magic, int& shift) {
+        constexpr unsigned int two_31 { 0x80000000u };
+
+        const unsigned int absolute_divisor { static_cast<unsigned int>((divisor < 0) ? -divisor : divisor) };
+        const unsigned int t { two_31 + (static_cast<unsigned int>(divisor) >> 31) };
+        const unsigned int absolute_nc { t - 1 - (t % absolute_divisor) };
+
+        int p { 31 };
+        unsigned int q1 { two_31 / absolute_nc };
+        unsigned int r1 { two_31 - (q1 * absolute_nc) };
+        unsigned int q2 { two_31 / absolute_divisor };
+        unsigned int r2 { two_31 - (q2 * absolute_divisor) };
+        unsigned int delta {};
+
+        do {
+            ++p;
+            q1 *= 2;
+            r1 *= 2;
+
+            if (r1 >= absolute_nc) {
+                ++q1;
+                r1 -= absolute_nc;
+            }
+
+            q2 *= 2;
+            r2 *= 2;
+
+            if (r2 >= absolute_divisor) {
+                ++q2;
+                r2 -= absolute_divisor;
+            }
+
+            delta = absolute_divisor - r2;
+        } while ((q1 < delta) || ((q1 == delta) && (r1 == 0)));
+
+        magic = static_cast<int>(q2 + 1);
+        magic = (divisor < 0) ? static_cast<int>(0u - static_cast<unsigned int>(magic)) : magic;
+        shift = p - 32;
+    }
+
+    // Cheaper replacement for "PUSH constant" followed by [op_code]. An empty replacement means both can be dropped.
+    static bool reduce_constant_arithmetic(int op_code, int constant, std::vector<std::array<int, 4>>& replacement) {
+        const int exponent { get_power_of_two((constant < 0) ? -static_cast<long long>(constant) : constant) };
+        const bool is_usable_divisor { (constant < -1) || (constant > 1) };
+        int magic {};
+        int shift {};
+
+        switch (op_code) {
+        case Instruction::mul:
+            if (constant == 1) {
+                replacement = {};
+            }
+            else if (constant == -1) {
+                replacement = { { Instruction::neg } };
+            }
+            else if ((constant > 0) && (exponent > 0)) {
+                replacement = { { Instruction::shl, exponent } };
+            }
+            else {
+                return false;
+            }
+
+            return true;
+
+        case Instruction::div:
+            if (constant == 1) {
+                replacement = {};
+            }
+            else if (constant == -1) {
+                replacement = { { Instruction::neg } };
+            }
+            else if ((constant > 0) && (exponent > 0)) {
+                replacement = { { Instruction::divp2, exponent } };
+            }
+            else if (is_usable_divisor && (constant != std::numeric_limits<int>::min())) {
+                compute_division_magic(constant, magic, shift);
+                replacement = { { Instruction::divm, constant, magic, shift } };
+            }
+            else {
+                return false;
+            }
+
+            return true;
+
+        case Instruction::mod:
+            if ((constant == 1) || (constant == -1)) {
+                replacement = { { Instruction::pop }, { Instruction::push, 0 } };
+            }
+            // The remainder takes the sign of the dividend, so negative divisors behave like positive ones.
+            else if ((exponent > 0) && (exponent < 31)) {
+                replacement = { { Instruction::modp2, exponent } };
+            }
+            else if (is_usable_divisor && (constant != std::numeric_limits<int>::min())) {
+                compute_division_magic(constant, magic, shift);
+                replacement = { { Instruction::modm, constant, magic, shift } };
+            }
+            else {
+                return false;
+            }
+
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+
+    //----------- Optimizer::Loop
+
+    // A counted loop: each iteration moves [counter_local] by [step] and continues while
+    //     "counter + offset <comparison> bound" holds, where the bound is a constant or a local the loop never changes.
+    struct Optimizer::Loop final {
+        std::size_t head {};
+        std::size_t back_edge {};
+        // For loops testing at the top, the conditional branch leaving the loop; otherwise, [back_edge].
+        std::size_t test_branch {};
+        bool test_at_top {};
+        // First of the pure operations computing the loop condition, which end right before [test_branch].
+        std::size_t test_start {};
+        // Number of values the condition consumes from beneath it, which must be popped when it is removed.
+        int test_consumed_values {};
+
+        int counter_local {};
+        long long step {};
+        int guard_comparison {};
+        // Guard condition checked before running the unrolled iterations: "counter + guard_offset <comparison> bound."
+        long long guard_offset {};
+        Linear_Value bound {};
+    };
+
+
+    //----------- Optimizer
+
+    Optimizer::Optimizer(std::vector<int>&& bytecode, int program_start_index, Settings settings) :
+        m_bytecode { std::move(bytecode) },
+        m_program_start_index { (program_start_index >= 0) ? program_start_index : 0 },
+        m_settings { settings } {}
+
+    std::vector<int> Optimizer::optimize() {
+        SVIM_PRINT_LINE("Optimizing...");
+
+        if (!decode()) {
+            SVIM_PRINT_LINE("Bytecode could not be decoded. Skipping optimization.");
+            return std::move(m_bytecode);
+        }
+
+        if (m_settings.constant_calls) {
+            evaluate_constant_calls();
+            remove_unreachable_code();
+        }
+
+        if (m_settings.tail_calls) {
+            eliminate_tail_calls();
+        }
+
+        if (m_settings.strength_reduction) {
+            reduce_strength();
+        }
+
+        unroll_loops();
+
+        if (m_settings.profile != nullptr) {
+            lay_out_blocks();
+        }
+
+        SVIM_PRINT_LINE("Optimizing complete!");
+        return encode();
+    }
+
+    bool Optimizer::decode() {
+        const int code_size { static_cast<int>(m_bytecode.size()) };
+
+        // Maps every bytecode address to the operation starting there, or s_no_target if it is an operand.
+        std::vector<int> address_labels(code_size + 1, s_no_target);
+        address_labels[code_size] = s_end_label;
+
+        m_operations.clear();
+
+        for (int address {}; address < code_size;) {
+            Operation operation { m_bytecode[address] };
+
+            if (!is_valid_op_code(operation.op_code)) {
+                return false;
+            }
+
+            const int operand_count { get_operand_count(operation.op_code) };
+
+            if ((address + operand_count) >= code_size) {
+                return false;
+            }
+
+            for (int i {}; i < operand_count; ++i) {
+                operation.operands[i] = m_bytecode[address + 1 + i];
+            }
+
+            operation.label = static_cast<int>(m_operations.size());
+            operation.source_address = address;
+            address_labels[address] = operation.label;
+
+            m_operations.push_back(operation);
+            address += 1 + operand_count;
+        }
+
+        for (Operation& operation : m_operations) {
+            if (!refers_to_address(operation.op_code)) {
+                continue;
+            }
+
+            const int address { operation.operands[0] };
+
+            if ((address < 0) || (address > code_size) || (address_labels[address] == s_no_target)) {
+                return false;
+            }
+
+            operation.target = address_labels[address];
+        }
+
+        if ((m_program_start_index > code_size) || (address_labels[m_program_start_index] == s_no_target)) {
+            return false;
+        }
+
+        m_entry_label = address_labels[m_program_start_index];
+        m_next_label = static_cast<int>(m_operations.size());
+        m_decoded = true;
+        return true;
+    }
+
+    std::vector<int> Optimizer::encode() {
+        std::vector<int> label_addresses {};
+        std::vector<int> bytecode { assemble(label_addresses) };
+
+        m_program_start_index = (m_entry_label == s_end_label) ? static_cast<int>(bytecode.size()) : label_addresses[m_entry_label];
+
+        SVIM_PRINT_PROPERTY("Bytecode size before", m_bytecode.size());
+        SVIM_PRINT_PROPERTY("Bytecode size after", bytecode.size());
+        SVIM_PRINT_PROPERTY("Program starting index", m_program_start_index);
+
+        return bytecode;
+    }
+
+    std::vector<int> Optimizer::assemble(std::vector<int>& label_addresses) const {
+        int code_size {};
+
+        for (const Operation& operation : m_operations) {
+            code_size += 1 + get_operand_count(operation.op_code);
+        }
+
+        label_addresses.assign(m_next_label, s_no_target);
+        int address {};
+
+        for (const Operation& operation : m_operations) {
+            label_addresses[operation.label] = address;
+            address += 1 + get_operand_count(operation.op_code);
+        }
+
+        auto to_address = [&](int label) {
+            return (label == s_end_label) ? code_size : label_addresses[label];
+        };
+
+        std::vector<int> bytecode {};
+        bytecode.reserve(code_size);
+
+        for (const Operation& operation : m_operations) {
+            bytecode.push_back(operation.op_code);
+
+            for (int i {}; i < get_operand_count(operation.op_code); ++i) {
+                const bool is_address { (i == 0) && (operation.target != s_no_target) };
+                bytecode.push_back(is_address ? to_address(operation.target) : operation.operands[i]);
+            }
+        }
+
+        return bytecode;
+    }
+
+    Line_Table Optimizer::map_line_table(const Line_Table& lines) const {
+        // Undecodable bytecode is returned untouched, so its lines still apply.
+        if (!m_decoded) {
+            return lines;
+        }
+
+        const std::vector<Line_Table::Row> rows { lines.get_rows() };
+        Line_Table mapped {};
+        int address {};
+
+        for (const Operation& operation : m_operations) {
+            const Source_Location location { Line_Table::find(rows, operation.source_address) };
+
+            if (location.is_known()) {
+                mapped.add(address, location);
+            }
+
+            address += 1 + get_operand_count(operation.op_code);
+        }
+
+        return mapped;
+    }
+
+    // "CALL f n" followed by "RET" returns whatever f returns, so f may as well return to our caller directly.
+    // The "RET" stays in place, as other branches may still target it.
+    void Optimizer::eliminate_tail_calls() {
+        for (std::size_t i {}; (i + 1) < m_operations.size(); ++i) {
+            Operation& current { m_operations[i] };
+
+            if ((current.op_code == Instruction::call) && (m_operations[i + 1].op_code == Instruction::ret)) {
+                current.op_code = Instruction::tcall;
+                SVIM_PRINT_DPROPERTY("Tail call at index", current.source_address);
+            }
+        }
+    }
+
+    // "PUSH c" followed by "MUL," "DIV," or "MOD" becomes shifts, negation, or reciprocal multiplication.
+    void Optimizer::reduce_strength() {
+        const std::vector<bool> referenced { find_referenced_labels() };
+        std::vector<std::array<int, 4>> replacement {};
+
+        for (std::size_t i {}; (i + 1) < m_operations.size(); ++i) {
+            const Operation& constant { m_operations[i] };
+            const Operation& arithmetic { m_operations[i + 1] };
+
+            if ((constant.op_code != Instruction::push) || referenced[arithmetic.label]) {
+                continue;
+            }
+
+            if (!reduce_constant_arithmetic(arithmetic.op_code, constant.operands[0], replacement)) {
+                continue;
+            }
+
+            // Dropping both operations would strand any branch targeting the "PUSH."
+            if (replacement.empty() && referenced[constant.label]) {
+                continue;
+            }
+
+            SVIM_PRINT_DPROPERTY("Reduced arithmetic at index", constant.source_address);
+
+            const int label { constant.label };
+            const int source_address { constant.source_address };
+
+            m_operations.erase(m_operations.begin() + i, m_operations.begin() + i + 2);
+
+            for (std::size_t j {}; j < replacement.size(); ++j) {
+                const std::array<int, 4>& values { replacement[j] };
+                Operation reduced { values[0], { values[1], values[2], values[3] }, (j == 0) ? label : create_label(), s_no_target, source_address };
+                m_operations.insert(m_operations.begin() + i + j, reduced);
+            }
+
+            if (replacement.empty()) {
+                // Revisit whatever moved into this spot.
+                --i;
+            }
+        }
+    }
+
+    // "PUSH a1 ... PUSH an" followed by "CALL f n" becomes "PUSH" of every value f leaves on the stack,
+    //     if f is pure and finishes within the evaluation budget. Sweeps repeat until no call changes,
+    //     as results may become constant arguments to enclosing calls.
+    void Optimizer::evaluate_constant_calls() {
+        bool changed { true };
+
+        while (changed) {
+            changed = false;
+
+            const std::vector<bool> referenced { find_referenced_labels() };
+            std::vector<std::size_t> label_indices(m_next_label, m_operations.size());
+
+            for (std::size_t i {}; i < m_operations.size(); ++i) {
+                label_indices[m_operations[i].label] = i;
+            }
+
+            // Purity per function label: 0 if not yet known, 1 if pure, and -1 if not.
+            std::vector<int> purity(m_next_label);
+            std::vector<Operation> evaluated {};
+            evaluated.reserve(m_operations.size());
+
+            for (std::size_t i {}; i < m_operations.size(); ++i) {
+                const Operation& call { m_operations[i] };
+                const int arg_count { call.operands[1] };
+
+                evaluated.push_back(call);
+
+                if ((call.op_code != Instruction::call) || (call.target < 0) || (arg_count < 0) ||
+                    (arg_count > Virtual_Machine::get_max_local_values()) || (static_cast<std::size_t>(arg_count) > i)) {
+                    continue;
+                }
+
+                const std::size_t first { i - arg_count };
+                bool constant_arguments { !referenced[call.label] };
+
+                // Branching between the arguments and the call would skip some of them.
+                for (std::size_t j { first }; constant_arguments && (j < i); ++j) {
+                    constant_arguments = (m_operations[j].op_code == Instruction::push) && ((j == first) || !referenced[m_operations[j].label]);
+                }
+
+                if (!constant_arguments) {
+                    continue;
+                }
+
+                if (purity[call.target] == 0) {
+                    purity[call.target] = (is_pure_function(call.target, label_indices)) ? 1 : -1;
+                }
+
+                std::vector<int> stack {};
+
+                for (std::size_t j { first }; j < i; ++j) {
+                    stack.push_back(m_operations[j].operands[0]);
+                }
+
+                if ((purity[call.target] < 0) || !evaluate_call(call.target, arg_count, label_indices, stack)) {
+                    continue;
+                }
+
+                // The results may not take more space than the call did, nor drop a label something branches to.
+                if ((stack.size() > static_cast<std::size_t>(arg_count + 1)) || (stack.empty() && referenced[m_operations[first].label])) {
+                    continue;
+                }
+
+                SVIM_PRINT_DPROPERTY("Evaluated call at index", call.source_address);
+
+                const int label { m_operations[first].label };
+                evaluated.resize(evaluated.size() - (arg_count + 1));
+
+                for (std::size_t j {}; j < stack.size(); ++j) {
+                    evaluated.push_back({ Instruction::push, { stack[j] }, (j == 0) ? label : create_label(), s_no_target, call.source_address });
+                }
+
+                changed = true;
+            }
+
+            m_operations = std::move(evaluated);
+        }
+    }
+
+    // A function is pure if nothing reachable from its entry reads or writes globals, prints, waits for input,
+    //     or ends the program.
+    bool Optimizer::is_pure_function(int label, const std::vector<std::size_t>& label_indices) const {
+        std::vector<bool> visited(m_operations.size());
+        std::vector<int> pending { label };
+
+        while (!pending.empty()) {
+            const int current { pending.back() };
+            pending.pop_back();
+
+            if ((current < 0) || (label_indices[current] >= m_operations.size())) {
+                return false;
+            }
+
+            for (std::size_t i { label_indices[current] }; !visited[i]; ++i) {
+                const Operation& operation { m_operations[i] };
+                visited[i] = true;
+
+                switch (operation.op_code) {
+                case Instruction::gpush:
+                case Instruction::gstore:
+                case Instruction::print:
+                case Instruction::halt:
+                case Instruction::exit:
+                    return false;
+
+                default:
+                    break;
+                }
+
+                if (operation.target != s_no_target) {
+                    pending.push_back(operation.target);
+                }
+
+                if (ends_control_flow(operation.op_code)) {
+                    break;
+                }
+
+                // Running off the end of the bytecode ends the program.
+                if ((i + 1) == m_operations.size()) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Runs the function at [label] the way Virtual_Machine would, starting from [stack] holding its arguments
+    //     and leaving whatever it returns there. Gives up if the function reaches into its caller's stack values,
+    //     runs anything but stack, local, arithmetic, branch, and call instructions, or runs out of budget.
+    bool Optimizer::evaluate_call(int label, int arg_count, const std::vector<std::size_t>& label_indices, std::vector<int>& stack) const {
+        std::vector<Evaluation_Frame> frames(1);
+        frames.back().return_index = m_operations.size();
+
+        for (int i {}; i < arg_count; ++i) {
+            frames.back().locals[i] = stack.back();
+            stack.pop_back();
+        }
+
+        auto pop = [&stack]() {
+            const int top { stack.back() };
+            stack.pop_back();
+            return top;
+        };
+
+        auto find_index = [&](int target) {
+            return (target >= 0) ? label_indices[target] : m_operations.size();
+        };
+
+        const int local_count { Virtual_Machine::get_max_local_values() };
+        std::size_t index { find_index(label) };
+
+        for (int budget { s_max_evaluated_instructions }; budget > 0; --budget) {
+            if ((index >= m_operations.size()) || (stack.size() > s_max_evaluated_stack_size)) {
+                return false;
+            }
+
+            const Operation& operation { m_operations[index++] };
+            const int operand { operation.operands[0] };
+            int pops {};
+            int pushes {};
+
+            if (get_stack_effect(operation.op_code, pops, pushes) && (stack.size() < static_cast<std::size_t>(pops))) {
+                return false;
+            }
+
+            std::array<int, Virtual_Machine::get_max_local_values()>& locals { frames.back().locals };
+
+            switch (operation.op_code) {
+            case Instruction::push:
+                stack.push_back(operand);
+                break;
+
+            case Instruction::lpush:
+                if ((operand < 0) || (operand >= local_count)) {
+                    return false;
+                }
+
+                stack.push_back(locals[operand]);
+                break;
+
+            case Instruction::lstore:
+                if ((operand < 0) || (operand >= local_count)) {
+                    return false;
+                }
+
+                locals[operand] = pop();
+                break;
+
+            case Instruction::add:
+            case Instruction::sub:
+            case Instruction::mul:
+            case Instruction::div:
+            case Instruction::mod:
+            case Instruction::lt:
+            case Instruction::gt:
+            case Instruction::eq:
+            case Instruction::leq:
+            case Instruction::geq:
+            case Instruction::neq:
+            {
+                const int b { pop() };
+                const int a { pop() };
+                int result {};
+
+                if (!evaluate_binary_operation(operation.op_code, a, b, result)) {
+                    return false;
+                }
+
+                stack.push_back(result);
+                break;
+            }
+
+            case Instruction::inc:
+                stack.back() = wrap_to_int(static_cast<long long>(stack.back()) + 1);
+                break;
+
+            case Instruction::dec:
+                stack.back() = wrap_to_int(static_cast<long long>(stack.back()) - 1);
+                break;
+
+            case Instruction::neg:
+                stack.back() = wrap_to_int(-static_cast<long long>(stack.back()));
+                break;
+
+            case Instruction::dup:
+                stack.push_back(stack.back());
+                break;
+
+            case Instruction::dup2:
+            {
+                const int under { stack[stack.size() - 2] };
+                const int top { stack.back() };
+                stack.push_back(under);
+                stack.push_back(top);
+                break;
+            }
+
+            case Instruction::swap:
+                std::swap(stack[stack.size() - 2], stack.back());
+                break;
+
+            case Instruction::over:
+                stack.push_back(stack[stack.size() - 2]);
+                break;
+
+            case Instruction::turn:
+            {
+                const int bottom { stack[stack.size() - 3] };
+                stack[stack.size() - 3] = stack[stack.size() - 2];
+                stack[stack.size() - 2] = stack.back();
+                stack.back() = bottom;
+                break;
+            }
+
+            case Instruction::pop:
+                stack.pop_back();
+                break;
+
+            case Instruction::br:
+                index = find_index(operation.target);
+                break;
+
+            case Instruction::brt:
+                if (stack.empty()) {
+                    return false;
+                }
+
+                index = (pop() != 0) ? find_index(operation.target) : index;
+                break;
+
+            case Instruction::brf:
+                if (stack.empty()) {
+                    return false;
+                }
+
+                index = (pop() == 0) ? find_index(operation.target) : index;
+                break;
+
+            case Instruction::call:
+            {
+                const int callee_arg_count { operation.operands[1] };
+
+                if ((callee_arg_count < 0) || (callee_arg_count > local_count) ||
+                    (stack.size() < static_cast<std::size_t>(callee_arg_count)) || (frames.size() >= s_max_evaluated_call_depth)) {
+                    return false;
+                }
+
+                Evaluation_Frame frame { index };
+
+                for (int i {}; i < callee_arg_count; ++i) {
+                    frame.locals[i] = pop();
+                }
+
+                frames.push_back(frame);
+                index = find_index(operation.target);
+                break;
+            }
+
+            case Instruction::ret:
+                if (frames.size() == 1) {
+                    return true;
+                }
+
+                index = frames.back().return_index;
+                frames.pop_back();
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    // Drops operations that no path from the program's entry reaches, such as functions whose every call was evaluated.
+    void Optimizer::remove_unreachable_code() {
+        std::vector<std::size_t> label_indices(m_next_label, m_operations.size());
+
+        for (std::size_t i {}; i < m_operations.size(); ++i) {
+            label_indices[m_operations[i].label] = i;
+        }
+
+        std::vector<bool> reachable(m_operations.size());
+        std::vector<int> pending { m_entry_label };
+
+        while (!pending.empty()) {
+            const int current { pending.back() };
+            pending.pop_back();
+
+            if (current < 0) {
+                continue;
+            }
+
+            for (std::size_t i { label_indices[current] }; (i < m_operations.size()) && !reachable[i]; ++i) {
+                const Operation& operation { m_operations[i] };
+                reachable[i] = true;
+
+                if (operation.target != s_no_target) {
+                    pending.push_back(operation.target);
+                }
+
+                if (ends_control_flow(operation.op_code)) {
+                    break;
+                }
+            }
+        }
+
+        std::vector<Operation> remaining {};
+        remaining.reserve(m_operations.size());
+
+        for (std::size_t i {}; i < m_operations.size(); ++i) {
+            if (reachable[i]) {
+                remaining.push_back(m_operations[i]);
+            }
+        }
+
+        SVIM_PRINT_DPROPERTY("Unreachable operations removed", m_operations.size() - remaining.size());
+        m_operations = std::move(remaining);
+    }
+
+    std::vector<bool> Optimizer::find_referenced_labels() const {
+        std::vector<bool> referenced(m_next_label);
+
+        if (m_entry_label >= 0) {
+            referenced[m_entry_label] = true;
+        }
+
+        for (const Operation& operation : m_operations) {
+            if (operation.target >= 0) {
+                referenced[operation.target] = true;
+            }
+        }
+
+        return referenced;
+    }
+
+    std::size_t Optimizer::find_operation(int label) const {
+        for (std::size_t i {}; i < m_operations.size(); ++i) {
+            if (m_operations[i].label == label) {
+                return i;
+            }
+        }
+
+        return m_operations.size();
+    }
+
+    // Counted loops get a guarded copy running [unroll_factor] iterations per back-edge, with the loop tests in between
+    //     removed. When the guard cannot prove all of those iterations will run, the original loop handles the remainder.
+    void Optimizer::unroll_loops() {
+        if (m_settings.unroll_factor < 2) {
+            return;
+        }
+
+        std::vector<bool> referenced { find_referenced_labels() };
+
+        for (std::size_t i {}; i < m_operations.size(); ++i) {
+            const Operation& branch { m_operations[i] };
+
+            if (!is_branch(branch.op_code) || (branch.target == s_end_label)) {
+                continue;
+            }
+
+            const std::size_t head { find_operation(branch.target) };
+            Loop loop {};
+
+            if ((head > i) || !analyze_loop(head, i, referenced, loop)) {
+                continue;
+            }
+
+            SVIM_PRINT_DPROPERTY("Unrolled loop at index", m_operations[head].source_address);
+
+            // Skip past both copies of the loop so the remainder loop is not unrolled again.
+            i = unroll_loop(loop) - 1;
+            referenced = find_referenced_labels();
+        }
+    }
+
+    bool Optimizer::analyze_loop(std::size_t head, std::size_t back_edge, const std::vector<bool>& referenced, Loop& loop) const {
+        if ((back_edge - head + 1) > s_max_unrolled_loop_size) {
+            return false;
+        }
+
+        // Nothing may jump into the middle of the loop.
+        for (std::size_t i { head + 1 }; i <= back_edge; ++i) {
+            if (referenced[m_operations[i].label]) {
+                return false;
+            }
+        }
+
+        loop.head = head;
+        loop.back_edge = back_edge;
+        loop.test_at_top = (m_operations[back_edge].op_code == Instruction::br);
+        loop.test_branch = back_edge;
+
+        if (loop.test_at_top) {
+            // "while" shape: the first branch must leave the loop for whatever follows the back-edge.
+            const int exit_label { ((back_edge + 1) < m_operations.size()) ? m_operations[back_edge + 1].label : s_end_label };
+
+            loop.test_branch = head;
+
+            while ((loop.test_branch < back_edge) && !is_branch(m_operations[loop.test_branch].op_code)) {
+                ++loop.test_branch;
+            }
+
+            const Operation& exit_branch { m_operations[loop.test_branch] };
+
+            if ((exit_branch.op_code == Instruction::br) || (exit_branch.target != exit_label)) {
+                return false;
+            }
+        }
+
+        for (std::size_t i { head }; i < back_edge; ++i) {
+            const int op_code { m_operations[i].op_code };
+
+            if ((i != loop.test_branch) && (is_branch(op_code) || (op_code == Instruction::ret) || (op_code == Instruction::tcall))) {
+                return false;
+            }
+        }
+
+        // Work out what one iteration does to the locals and what the loop condition compares.
+        Symbolic_State state {};
+
+        for (int i {}; i < static_cast<int>(state.locals.size()); ++i) {
+            state.locals[i] = { Linear_Value::Kind::local, i, 0 };
+        }
+
+        Symbol condition {};
+
+        for (std::size_t i { head }; i < back_edge; ++i) {
+            const Operation& operation { m_operations[i] };
+
+            if (i == loop.test_branch) {
+                condition = state.pop();
+            }
+            else if (!evaluate_symbolically(state, operation.op_code, operation.operands[0])) {
+                return false;
+            }
+        }
+
+        if (!loop.test_at_top) {
+            condition = state.pop();
+        }
+
+        // A bare value as a condition is a comparison against 0.
+        Linear_Value left { condition.value };
+        Linear_Value right { Linear_Value::Kind::constant, 0, 0 };
+        int comparison { Instruction::neq };
+
+        if (condition.is_comparison()) {
+            right = condition.right;
+            comparison = condition.comparison;
+        }
+
+        // Normalize to the comparison under which the loop keeps going.
+        const int test_op_code { m_operations[loop.test_branch].op_code };
+        const bool continues_when_true { (loop.test_at_top) ? (test_op_code == Instruction::brf) : (test_op_code == Instruction::brt) };
+
+        if (!continues_when_true) {
+            comparison = negate_comparison(comparison);
+        }
+
+        auto is_counter = [&](const Linear_Value& value) {
+            if (!value.is_local()) {
+                return false;
+            }
+
+            const Linear_Value& final_value { state.locals[value.local] };
+            return final_value.is_local() && (final_value.local == value.local) && (final_value.offset != 0);
+        };
+
+        auto is_invariant = [&](const Linear_Value& value) {
+            if (value.is_constant()) {
+                return true;
+            }
+
+            const Linear_Value& final_value { state.locals[value.local] };
+            return value.is_local() && final_value.is_local() && (final_value.local == value.local) && (final_value.offset == 0);
+        };
+
+        if (!is_counter(left)) {
+            std::swap(left, right);
+            comparison = mirror_comparison(comparison);
+        }
+
+        if (!is_counter(left) || !is_invariant(right)) {
+            return false;
+        }
+
+        loop.counter_local = left.local;
+        loop.step = state.locals[left.local].offset;
+        loop.bound = right;
+
+        // Comparisons whose outcome only flips once as the counter moves, so checking the last iteration covers the rest.
+        // "!=" is conservatively guarded as "<" or ">."
+        if ((loop.step > 0) && ((comparison == Instruction::lt) || (comparison == Instruction::leq) || (comparison == Instruction::neq))) {
+            loop.guard_comparison = (comparison == Instruction::neq) ? Instruction::lt : comparison;
+        }
+        else if ((loop.step < 0) && ((comparison == Instruction::gt) || (comparison == Instruction::geq) || (comparison == Instruction::neq))) {
+            loop.guard_comparison = (comparison == Instruction::neq) ? Instruction::gt : comparison;
+        }
+        else {
+            return false;
+        }
+
+        // Find the pure operations computing the condition, which the unrolled iterations drop.
+        const auto operations_start { m_operations.begin() };
+
+        if (loop.test_at_top) {
+            loop.test_start = head;
+
+            if (!computes_single_value(operations_start + head, operations_start + loop.test_branch, loop.test_consumed_values)) {
+                return false;
+            }
+        }
+        else {
+            bool found {};
+
+            for (std::size_t start { head }; start < back_edge; ++start) {
+                if (computes_single_value(operations_start + start, operations_start + back_edge, loop.test_consumed_values)) {
+                    loop.test_start = start;
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found) {
+                return false;
+            }
+        }
+
+        // Loops testing at the bottom keep the test of their last unrolled iteration.
+        const int removed_tests { (loop.test_at_top) ? m_settings.unroll_factor : (m_settings.unroll_factor - 1) };
+        loop.guard_offset = left.offset + ((removed_tests - 1) * loop.step);
+
+        // The offset is emitted on whichever side of the guard unroll_loop() folds it into.
+        const long long guard_operand { (right.is_constant()) ? (right.offset - loop.guard_offset) : (loop.guard_offset - right.offset) };
+        return fits_in_operand(guard_operand);
+    }
+
+    std::size_t Optimizer::unroll_loop(const Loop& loop) {
+        const std::vector<Operation> original { m_operations.begin() + loop.head, m_operations.begin() + loop.back_edge + 1 };
+        const int head_label { original.front().label };
+        const int source_address { original.front().source_address };
+        const int exit_label { ((loop.back_edge + 1) < m_operations.size()) ? m_operations[loop.back_edge + 1].label : s_end_label };
+
+        // The untouched loop, relabeled, runs whatever iterations the unrolled copy cannot.
+        std::vector<Operation> remainder { original };
+
+        for (Operation& operation : remainder) {
+            operation.label = create_label();
+        }
+
+        remainder.back().target = remainder.front().label;
+
+        std::vector<Operation> unrolled {};
+
+        auto emit = [&](int op_code, int operand, int target) {
+            unrolled.push_back({ op_code, { operand }, create_label(), target, source_address });
+        };
+
+        auto emit_copy = [&](std::size_t first, std::size_t last) {
+            for (std::size_t i { first }; i < last; ++i) {
+                Operation copy { original[i - loop.head] };
+                copy.label = create_label();
+                unrolled.push_back(copy);
+            }
+        };
+
+        auto emit_test_removal = [&]() {
+            for (int i {}; i < loop.test_consumed_values; ++i) {
+                emit(Instruction::pop, 0, s_no_target);
+            }
+        };
+
+        // Guard: "counter + guard_offset <comparison> bound," with the offset folded into whichever side is cheaper.
+        if (loop.bound.is_constant()) {
+            emit(Instruction::lpush, loop.counter_local, s_no_target);
+            emit(Instruction::push, static_cast<int>(loop.bound.offset - loop.guard_offset), s_no_target);
+        }
+        else {
+            const int offset { static_cast<int>(loop.guard_offset - loop.bound.offset) };
+
+            // Counters too close to the edge of the int range for the offset to be added leave it to the remainder loop.
+            if (offset != 0) {
+                const long long limit { (offset > 0) ? (std::numeric_limits<int>::max() - offset) : (std::numeric_limits<int>::min() - offset) };
+                emit(Instruction::lpush, loop.counter_local, s_no_target);
+                emit(Instruction::push, static_cast<int>(limit), s_no_target);
+                emit((offset > 0) ? Instruction::leq : Instruction::geq, 0, s_no_target);
+                emit(Instruction::brf, 0, remainder.front().label);
+            }
+
+            emit(Instruction::lpush, loop.counter_local, s_no_target);
+
+            if ((offset == 1) || (offset == -1)) {
+                emit((offset == 1) ? Instruction::inc : Instruction::dec, 0, s_no_target);
+            }
+            else if (offset != 0) {
+                emit(Instruction::push, offset, s_no_target);
+                emit(Instruction::add, 0, s_no_target);
+            }
+
+            emit(Instruction::lpush, loop.bound.local, s_no_target);
+        }
+
+        emit(loop.guard_comparison, 0, s_no_target);
+        emit(Instruction::brf, 0, remainder.front().label);
+
+        // Branches into the loop now land on the guard.
+        unrolled.front().label = head_label;
+
+        if (loop.test_at_top) {
+            for (int i {}; i < m_settings.unroll_factor; ++i) {
+                emit_test_removal();
+                emit_copy(loop.test_branch + 1, loop.back_edge);
+            }
+
+            emit(Instruction::br, 0, head_label);
+        }
+        else {
+            for (int i {}; i < (m_settings.unroll_factor - 1); ++i) {
+                const std::size_t copy_start { unrolled.size() };
+                emit_copy(loop.head, loop.test_start);
+                emit_test_removal();
+                remove_discarded_duplicates(unrolled, copy_start);
+            }
+
+            emit_copy(loop.head, loop.back_edge + 1);
+            unrolled.back().target = head_label;
+            emit(Instruction::br, 0, exit_label);
+        }
+
+        m_operations.erase(m_operations.begin() + loop.head, m_operations.begin() + loop.back_edge + 1);
+        m_operations.insert(m_operations.begin() + loop.head, remainder.begin(), remainder.end());
+        m_operations.insert(m_operations.begin() + loop.head, unrolled.begin(), unrolled.end());
+
+        return loop.head + unrolled.size() + remainder.size();
+    }
+
+    // Chains blocks along their most frequently taken edges so hot paths fall through, then appends blocks that never ran.
+    // Conditional branches are inverted, or followed by a new "BR," wherever their old fall-through moved away.
+    void Optimizer::lay_out_blocks() {
+        std::vector<int> label_addresses {};
+
+        if (!m_settings.profile->matches(assemble(label_addresses))) {
+            SVIM_PRINT_LINE("Execution profile does not match the bytecode. Skipping block layout.");
+            return;
+        }
+
+        m_profile_applied = true;
+
+        const Execution_Profile& profile { *m_settings.profile };
+        const std::vector<bool> referenced { find_referenced_labels() };
+
+        std::vector<Basic_Block> blocks {};
+        std::vector<int> label_blocks(m_next_label, Basic_Block::s_none);
+
+        for (std::size_t i {}; i < m_operations.size(); ++i) {
+            const bool starts_block { (i == 0) || referenced[m_operations[i].label] || is_branch(m_operations[i - 1].op_code) || ends_control_flow(m_operations[i - 1].op_code) };
+
+            if (starts_block) {
+                blocks.push_back({ i, i });
+                label_blocks[m_operations[i].label] = static_cast<int>(blocks.size() - 1);
+            }
+
+            blocks.back().last = i + 1;
+        }
+
+        if (blocks.size() < 2) {
+            return;
+        }
+
+        for (std::size_t b {}; b < blocks.size(); ++b) {
+            Basic_Block& block { blocks[b] };
+            const Operation& terminator { m_operations[block.last - 1] };
+            const int terminator_address { label_addresses[terminator.label] };
+            const std::uint64_t executions { profile.get_execution_count(terminator_address) };
+            const std::uint64_t taken { profile.get_taken_count(terminator_address) };
+
+            block.executions = profile.get_execution_count(label_addresses[m_operations[block.first].label]);
+
+            if (!ends_control_flow(terminator.op_code)) {
+                block.fall_through = ((b + 1) < blocks.size()) ? static_cast<int>(b + 1) : Basic_Block::s_program_end;
+                block.fall_through_weight = executions - taken;
+            }
+
+            if (is_branch(terminator.op_code)) {
+                block.target = (terminator.target == s_end_label) ? Basic_Block::s_program_end : label_blocks[terminator.target];
+                block.target_weight = (terminator.op_code == Instruction::br) ? executions : taken;
+            }
+        }
+
+        std::vector<bool> placed(blocks.size());
+        std::vector<int> order {};
+        order.reserve(blocks.size());
+
+        auto place_chain = [&](int seed, bool hot) {
+            for (int current { seed }; (current >= 0) && !placed[current];) {
+                placed[current] = true;
+                order.push_back(current);
+
+                const Basic_Block& block { blocks[current] };
+                int next { Basic_Block::s_none };
+                std::uint64_t next_weight {};
+
+                auto consider = [&](int successor, std::uint64_t weight) {
+                    if ((successor < 0) || placed[successor] || ((blocks[successor].executions > 0) != hot)) {
+                        return;
+                    }
+
+                    // Cold chains simply keep their original fall-through.
+                    if ((hot && (weight > next_weight)) || (!hot && (next == Basic_Block::s_none))) {
+                        next = successor;
+                        next_weight = weight;
+                    }
+                };
+
+                consider(block.fall_through, block.fall_through_weight);
+                consider(block.target, block.target_weight);
+                current = next;
+            }
+        };
+
+        const int entry_block { (m_entry_label >= 0) ? label_blocks[m_entry_label] : 0 };
+
+        if (blocks[entry_block].executions > 0) {
+            place_chain(entry_block, true);
+        }
+
+        for (int b {}; b < static_cast<int>(blocks.size()); ++b) {
+            if (!placed[b] && (blocks[b].executions > 0)) {
+                place_chain(b, true);
+            }
+        }
+
+        for (int b {}; b < static_cast<int>(blocks.size()); ++b) {
+            if (!placed[b]) {
+                place_chain(b, false);
+            }
+        }
+
+        std::vector<Operation> laid_out {};
+        laid_out.reserve(m_operations.size() + blocks.size());
+
+        for (std::size_t k {}; k < order.size(); ++k) {
+            const Basic_Block& block { blocks[order[k]] };
+            const int next { ((k + 1) < order.size()) ? order[k + 1] : Basic_Block::s_program_end };
+
+            laid_out.insert(laid_out.end(), m_operations.begin() + block.first, m_operations.begin() + block.last);
+
+            if ((block.fall_through == Basic_Block::s_none) || (block.fall_through == next)) {
+                continue;
+            }
+
+            Operation& terminator { laid_out.back() };
+            const int source_address { terminator.source_address };
+
+            if ((terminator.op_code == Instruction::brt || terminator.op_code == Instruction::brf) &&
+                (block.target == next) && (block.fall_through >= 0)) {
+                terminator.op_code = (terminator.op_code == Instruction::brt) ? Instruction::brf : Instruction::brt;
+                terminator.target = m_operations[blocks[block.fall_through].first].label;
+            }
+            else if (block.fall_through == Basic_Block::s_program_end) {
+                laid_out.push_back({ Instruction::exit, {}, create_label(), s_no_target, source_address });
+            }
+            else {
+                laid_out.push_back({ Instruction::br, {}, create_label(), m_operations[blocks[block.fall_through].first].label, source_address });
+            }
+        }
+
+        m_operations = std::move(laid_out);
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "execution_profile.h"
+#include "line_table.h"
+
+namespace svim {
+    // Rewrites parsed bytecode into an equivalent but cheaper program before it is handed to Virtual_Machine.
+    // If the bytecode cannot be fully decoded (e.g., a branch lands in the middle of an instruction),
+    //     it is returned untouched.
+    class Optimizer final {
+    public:
+        struct Settings {
+            // Replaces calls to pure functions with constant arguments by the values they return,
+            //     then drops code that can no longer be reached.
+            bool constant_calls { true };
+            bool tail_calls { true };
+            // Replaces multiplication and division by constants with shifts and reciprocal multiplication.
+            bool strength_reduction { true };
+            // How many iterations of a counted loop run per back-edge. Values below 2 disable unrolling.
+            int unroll_factor { 4 };
+            // If given, basic blocks are reordered so the hottest successor of each block falls through.
+            //     It must have been recorded from this optimizer's output under the same settings (minus the profile).
+            const Execution_Profile* profile {};
+        };
+
+        Optimizer(std::vector<int>&& bytecode, int program_start_index, Settings settings);
+
+        std::vector<int> optimize();
+
+        int get_program_start_index() const { return m_program_start_index; }
+        bool is_profile_applied() const { return m_profile_applied; }
+        // Moves [lines], written for the bytecode given to the constructor, onto the bytecode optimize() returned.
+        // Instructions the optimizer created take the location of the instruction they replaced.
+        Line_Table map_line_table(const Line_Table& lines) const;
+
+        Optimizer(const Optimizer& other) = delete;
+        Optimizer& operator =(const Optimizer& other) = delete;
+
+    private:
+        inline static constexpr int s_max_operands { 3 };
+        inline static constexpr int s_no_target { -1 };
+        // Label for the address one past the last instruction. Running into it ends the program.
+        inline static constexpr int s_end_label { -2 };
+        // Loops with longer iterations than this are left rolled.
+        inline static constexpr int s_max_unrolled_loop_size { 32 };
+        // Calls taking more instructions than this to evaluate are left for the virtual machine.
+        inline static constexpr int s_max_evaluated_instructions { 100000 };
+        inline static constexpr std::size_t s_max_evaluated_stack_size { 1024 };
+        inline static constexpr std::size_t s_max_evaluated_call_depth { 256 };
+
+        // A decoded instruction. Branches refer to other operations through labels rather than addresses,
+        //     so passes may insert and remove operations freely; addresses are recomputed by encode().
+        struct Operation {
+            int op_code {};
+            std::array<int, s_max_operands> operands {};
+            int label {};
+            int target { s_no_target };
+            int source_address {};
+        };
+
+        struct Loop;
+
+        std::vector<int> m_bytecode {};
+        int m_program_start_index {};
+        Settings m_settings {};
+
+        std::vector<Operation> m_operations {};
+        int m_entry_label {};
+        int m_next_label {};
+        bool m_profile_applied {};
+        bool m_decoded {};
+
+        bool decode();
+        std::vector<int> encode();
+        std::vector<int> assemble(std::vector<int>& label_addresses) const;
+
+        int create_label() { return m_next_label++; }
+        std::vector<bool> find_referenced_labels() const;
+        std::size_t find_operation(int label) const;
+
+        void evaluate_constant_calls();
+        bool is_pure_function(int label, const std::vector<std::size_t>& label_indices) const;
+        bool evaluate_call(int label, int arg_count, const std::vector<std::size_t>& label_indices, std::vector<int>& stack) const;
+        void remove_unreachable_code();
+
+        void eliminate_tail_calls();
+        void reduce_strength();
+
+        void unroll_loops();
+        bool analyze_loop(std::size_t head, std::size_t back_edge, const std::vector<bool>& referenced, Loop& loop) const;
+        std::size_t unroll_loop(const Loop& loop);
+
+        void lay_out_blocks();
+    };
+}
@@ -72,6 +72,7 @@ namespace svim {
         std::string line {};
         m_expected_operand_count = 0;
         m_line_count = 0;
+        m_line_table = {};
 
         SVIM_PRINT_LINE("Parsing...");
 
@@ -145,6 +146,7 @@ namespace svim {
                 SVIM_PRINT_DPROPERTY("Instruction token", token);
 
                 int op_code { to_instruction(token) };
+                m_line_table.add(static_cast<int>(bytecode.size()), { m_line_count, static_cast<int>(token.data() - line.data()) + 1 });
                 bytecode.push_back(op_code);
 
                 if (m_entry_point_status == Entry_Point_Search_Status::expecting) {
@@ -241,7 +243,7 @@ namespace svim {
         }
 
         for (const Instruction_Data& instruction : g_instruction_data) {
-            if (token == instruction.name) {
+            if (!instruction.internal && (token == instruction.name)) {
                 m_expected_operand_count = instruction.expected_following_values;
                 return instruction.value;
             }
@@ -4,6 +4,7 @@
 #include <string_view>
 #include <vector>
 #include <fstream>
+#include "line_table.h"
 
 namespace svim {
     class Parser final {
@@ -27,6 +28,8 @@ namespace svim {
 
         Status get_status() const { return m_status; }
         int get_program_start_index() const { return m_program_start_index; }
+        // Where each instruction returned by parse() was written.
+        const Line_Table& get_line_table() const { return m_line_table; }
 
     private:
         enum class Entry_Point_Search_Status {
@@ -47,6 +50,7 @@ namespace svim {
         int m_expected_operand_count {};
         int m_program_start_index { 0 };
         Entry_Point_Search_Status m_entry_point_status { Entry_Point_Search_Status::not_found };
+        Line_Table m_line_table {};
 
         void open_source_file();
         void parse_line(std::vector<int>& bytecode, const std::string& line);
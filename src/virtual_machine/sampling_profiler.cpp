@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "sampling_profiler.h"
+#include "instructions.h"
+#include "common/error.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#if !defined(_WIN32)
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+namespace svim {
+    //----------- Internal Data
+
+    // Signal handlers may only touch lock-free atomics.
+    static_assert(std::atomic<unsigned int>::is_always_lock_free);
+
+    static std::atomic<unsigned int>* g_sample_flags {};
+    static unsigned int g_sample_flag {};
+
+#if !defined(_WIN32)
+    static struct sigaction g_previous_action {};
+#endif
+
+
+    //----------- Helper Functions
+
+    static void append_function_name(std::ostream& output, int function_entry, bool is_main) {
+        if (is_main) {
+            output << "main";
+        }
+        else {
+            output << "fn@" << function_entry;
+        }
+    }
+
+    static double get_share(std::uint64_t count, std::uint64_t total) {
+        return 100.0 * static_cast<double>(count) / static_cast<double>(total);
+    }
+
+#if !defined(_WIN32)
+    static void request_sample(int) {
+        std::atomic<unsigned int>* const flags { g_sample_flags };
+
+        if (flags != nullptr) {
+            flags->fetch_or(g_sample_flag, std::memory_order_relaxed);
+        }
+    }
+#endif
+
+
+    //----------- Sampling_Profiler
+
+    Sampling_Profiler::Sampling_Profiler(int interval_microseconds) :
+        m_interval_microseconds { (interval_microseconds > 0) ? interval_microseconds : 1 } {}
+
+    Sampling_Profiler::~Sampling_Profiler() {
+        stop();
+    }
+
+#if defined(_WIN32)
+    void Sampling_Profiler::start(std::atomic<unsigned int>& flags, unsigned int flag) {
+        throw std::runtime_error("Sampling profiles need POSIX interval timers, which this platform does not have.");
+    }
+
+    void Sampling_Profiler::stop() {}
+#else
+    void Sampling_Profiler::start(std::atomic<unsigned int>& flags, unsigned int flag) {
+        if (g_sample_flags != nullptr) {
+            throw std::runtime_error("Only one sampling profile can be recorded at a time.");
+        }
+
+        g_sample_flags = &flags;
+        g_sample_flag = flag;
+
+        struct sigaction action {};
+        action.sa_handler = request_sample;
+        // Keeps blocking reads, such as the one "HALT" makes, from failing when a sample is requested.
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+
+        if (::sigaction(SIGPROF, &action, &g_previous_action) != 0) {
+            g_sample_flags = nullptr;
+            throw std::runtime_error("Could not install the sampling profiler's signal handler.");
+        }
+
+        const long seconds { m_interval_microseconds / 1000000 };
+        const long microseconds { m_interval_microseconds % 1000000 };
+        itimerval timer { { seconds, microseconds }, { seconds, microseconds } };
+
+        if (::setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+            ::sigaction(SIGPROF, &g_previous_action, nullptr);
+            g_sample_flags = nullptr;
+            throw std::runtime_error("Could not start the sampling profiler's timer.");
+        }
+
+        m_running = true;
+    }
+
+    void Sampling_Profiler::stop() {
+        if (!m_running) {
+            return;
+        }
+
+        itimerval timer {};
+        ::setitimer(ITIMER_PROF, &timer, nullptr);
+        ::sigaction(SIGPROF, &g_previous_action, nullptr);
+
+        g_sample_flags = nullptr;
+        m_running = false;
+    }
+#endif
+
+    void Sampling_Profiler::record(const std::vector<int>& function_entries, int address, int op_code) {
+        ++m_sample_count;
+        ++m_stack_samples[function_entries];
+
+        Address_Samples& samples { m_address_samples[address] };
+        ++samples.count;
+        samples.op_code = op_code;
+        samples.function_entry = (function_entries.size() > 1) ? function_entries.back() : s_main_function;
+    }
+
+    void Sampling_Profiler::save_collapsed_stacks(std::string_view profile_file) const {
+        std::ofstream output { std::string(profile_file) };
+
+        if (!output.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open sampling profile \"" << profile_file << "\" for writing.";
+            throw File_Open_Failure(message.str());
+        }
+
+        for (const auto& [function_entries, count] : m_stack_samples) {
+            for (std::size_t i {}; i < function_entries.size(); ++i) {
+                if (i > 0) {
+                    output << ';';
+                }
+
+                append_function_name(output, function_entries[i], i == 0);
+            }
+
+            output << ' ' << count << '\n';
+        }
+    }
+
+    void Sampling_Profiler::print_hot_addresses(std::ostream& output, std::size_t limit, const Line_Table& lines) const {
+        const std::vector<Line_Table::Row> rows { lines.get_rows() };
+        std::vector<std::pair<int, Address_Samples>> hottest { m_address_samples.begin(), m_address_samples.end() };
+        std::map<int, std::uint64_t> line_samples {};
+
+        for (const auto& [address, samples] : hottest) {
+            const Source_Location location { Line_Table::find(rows, address) };
+
+            if (location.is_known()) {
+                line_samples[location.line] += samples.count;
+            }
+        }
+
+        std::sort(hottest.begin(), hottest.end(), [](const auto& a, const auto& b) {
+            return (a.second.count != b.second.count) ? (a.second.count > b.second.count) : (a.first < b.first);
+        });
+
+        if (hottest.size() > limit) {
+            hottest.resize(limit);
+        }
+
+        output << "Sampled " << m_sample_count << " times. Hottest instructions:\n" << std::fixed << std::setprecision(2);
+
+        for (const auto& [address, samples] : hottest) {
+            output
+                << "    " << std::setw(7) << get_share(samples.count, m_sample_count) << "%  "
+                << std::setw(8) << samples.count << "  Index " << std::setw(6) << address << "  "
+                << std::setw(6) << std::left << g_instruction_data[samples.op_code].name << std::right << "  in ";
+
+            append_function_name(output, samples.function_entry, samples.function_entry == s_main_function);
+
+            const Source_Location location { Line_Table::find(rows, address) };
+
+            if (location.is_known()) {
+                output << "  (line " << location.line << ')';
+            }
+
+            output << '\n';
+        }
+
+        if (!line_samples.empty()) {
+            std::vector<std::pair<int, std::uint64_t>> hottest_lines { line_samples.begin(), line_samples.end() };
+
+            std::sort(hottest_lines.begin(), hottest_lines.end(), [](const auto& a, const auto& b) {
+                return (a.second != b.second) ? (a.second > b.second) : (a.first < b.first);
+            });
+
+            if (hottest_lines.size() > limit) {
+                hottest_lines.resize(limit);
+            }
+
+            output << "Hottest lines:\n";
+
+            for (const auto& [line, count] : hottest_lines) {
+                output
+                    << "    " << std::setw(7) << get_share(count, m_sample_count) << "%  "
+                    << std::setw(8) << count << "  Line " << line << '\n';
+            }
+        }
+
+        output.unsetf(std::ios::floatfield);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "line_table.h"
+
+namespace svim {
+    // Samples where a program is spending its time on a CPU-time interval timer ("SIGPROF").
+    // The signal handler only raises a flag; the sample itself is taken by Virtual_Machine at the next
+    //     instruction boundary, so the handler never touches state the interpreter might be changing.
+    // Only one profiler may be running at a time. Where POSIX interval timers are missing, start() throws.
+    class Sampling_Profiler final {
+    public:
+        explicit Sampling_Profiler(int interval_microseconds);
+        // Stops the timer if it is still running.
+        ~Sampling_Profiler();
+
+        // Arms the timer. Every tick sets [flag] in [flags].
+        void start(std::atomic<unsigned int>& flags, unsigned int flag);
+        void stop();
+
+        // [function_entries] holds the entry address of every function on the call stack, outermost first,
+        //     starting with the frame the program started in. [op_code] is the instruction at [address].
+        void record(const std::vector<int>& function_entries, int address, int op_code);
+
+        std::uint64_t get_sample_count() const { return m_sample_count; }
+
+        // Writes one line per distinct call stack in the collapsed format flame graph tools read
+        //     ("main;fn@12;fn@30 42").
+        void save_collapsed_stacks(std::string_view profile_file) const;
+        // Prints the [limit] addresses that were sampled most often, with the instruction at each.
+        // If [lines] is not empty, the source line of each is shown too, followed by the [limit] hottest lines.
+        void print_hot_addresses(std::ostream& output, std::size_t limit, const Line_Table& lines) const;
+
+        Sampling_Profiler(const Sampling_Profiler& other) = delete;
+        Sampling_Profiler& operator =(const Sampling_Profiler& other) = delete;
+
+    private:
+        struct Address_Samples {
+            std::uint64_t count {};
+            int op_code {};
+            // Entry address of the function the samples landed in, or s_main_function.
+            int function_entry {};
+        };
+
+        inline static constexpr int s_main_function { -1 };
+
+        int m_interval_microseconds {};
+        bool m_running {};
+        std::uint64_t m_sample_count {};
+        std::map<std::vector<int>, std::uint64_t> m_stack_samples {};
+        std::map<int, Address_Samples> m_address_samples {};
+    };
+}
@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "timeline.h"
+#include "common/error.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace svim {
+    //----------- Internal Data
+
+    // Matches the call stack Virtual_Machine reserves, so ordinary programs never grow it while running.
+    static constexpr std::size_t g_default_active_call_capacity { 64 };
+
+
+    //----------- Helper Functions
+
+    // Trace events count time in microseconds.
+    static void write_microseconds(std::ostream& output, std::int64_t nanoseconds) {
+        output << (nanoseconds / 1000) << '.' << std::setw(3) << std::setfill('0') << (nanoseconds % 1000) << std::setfill(' ');
+    }
+
+
+    //----------- Timeline
+
+    Timeline::Timeline(std::size_t capacity, std::int64_t minimum_call_nanoseconds) :
+        m_capacity { capacity },
+        m_minimum_call_nanoseconds { minimum_call_nanoseconds }
+    {
+        m_calls.reserve(m_capacity);
+        m_active_calls.reserve(g_default_active_call_capacity);
+    }
+
+    void Timeline::add_phase(std::string_view name, Time_Point start, std::int64_t duration) {
+        m_phases.push_back({ name, start, duration });
+    }
+
+    void Timeline::begin(int entry_index) {
+        m_main_entry_index = entry_index;
+        enter(entry_index);
+    }
+
+    void Timeline::enter(int entry_index) {
+        m_active_calls.push_back({ get_current_time(), 0, entry_index });
+    }
+
+    void Timeline::tail_call(int entry_index) {
+        if (m_active_calls.empty()) {
+            return;
+        }
+
+        const Time_Point now { get_current_time() };
+        end_call(now, false);
+        m_active_calls.push_back({ now, 0, entry_index });
+    }
+
+    void Timeline::leave() {
+        if (m_active_calls.empty()) {
+            return;
+        }
+
+        end_call(get_current_time(), false);
+    }
+
+    void Timeline::finish() {
+        const Time_Point now { get_current_time() };
+
+        while (!m_active_calls.empty()) {
+            end_call(now, true);
+        }
+    }
+
+    void Timeline::end_call(Time_Point end, bool is_kept_past_capacity) {
+        Call call { m_active_calls.back() };
+        m_active_calls.pop_back();
+        call.duration = get_elapsed_nanoseconds(call.start, end);
+
+        if (call.duration < m_minimum_call_nanoseconds) {
+            return;
+        }
+
+        if ((m_calls.size() >= m_capacity) && !is_kept_past_capacity) {
+            ++m_dropped_calls;
+            return;
+        }
+
+        m_calls.push_back(call);
+    }
+
+    void Timeline::save(std::string_view timeline_file, const Line_Table& lines) const {
+        std::ofstream output { std::string(timeline_file) };
+
+        if (!output.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open timeline file \"" << timeline_file << "\" for writing.";
+            throw File_Open_Failure(message.str());
+        }
+
+        // Viewers nest spans on the same thread by start time, taking the longer of two that start together as the outer one.
+        std::vector<Call> calls { m_calls };
+
+        std::sort(calls.begin(), calls.end(), [](const Call& left, const Call& right) {
+            return (left.start < right.start) || ((left.start == right.start) && (left.duration > right.duration));
+        });
+
+        Time_Point origin { calls.empty() ? get_current_time() : calls.front().start };
+
+        for (const Phase& phase : m_phases) {
+            origin = std::min(origin, phase.start);
+        }
+
+        const std::vector<Line_Table::Row> rows { lines.get_rows() };
+
+        output
+            << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_calls\":" << m_dropped_calls << "},\"traceEvents\":[\n"
+            << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"svim\"}},\n"
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"interpreter\"}}";
+
+        for (const Phase& phase : m_phases) {
+            output << ",\n{\"name\":\"" << phase.name << "\",\"cat\":\"phase\",\"ph\":\"X\",\"ts\":";
+            write_microseconds(output, get_elapsed_nanoseconds(origin, phase.start));
+            output << ",\"dur\":";
+            write_microseconds(output, phase.duration);
+            output << ",\"pid\":1,\"tid\":1}";
+        }
+
+        for (const Call& call : calls) {
+            output << ",\n{\"name\":\"";
+
+            if (call.entry_index == m_main_entry_index) {
+                output << "main";
+            }
+            else {
+                output << "fn@" << call.entry_index;
+            }
+
+            output << "\",\"cat\":\"call\",\"ph\":\"X\",\"ts\":";
+            write_microseconds(output, get_elapsed_nanoseconds(origin, call.start));
+            output << ",\"dur\":";
+            write_microseconds(output, call.duration);
+            output << ",\"pid\":1,\"tid\":1,\"args\":{\"entry\":" << call.entry_index;
+
+            const Source_Location location { Line_Table::find(rows, call.entry_index) };
+
+            if (location.is_known()) {
+                output << ",\"line\":" << location.line;
+            }
+
+            output << "}}";
+        }
+
+        output << "\n]}\n";
+    }
+}
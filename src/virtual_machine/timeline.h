@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "common/timer.h"
+#include "line_table.h"
+
+namespace svim {
+    // Spans of the application's phases and of every function call, saved as Chrome trace-event JSON
+    //     for Perfetto or "chrome://tracing."
+    // Virtual_Machine only reads the clock as functions are entered and left; spans are kept in memory,
+    //     up to a fixed number of calls, and formatted once the program ends.
+    // Functions are identified by the index they start at; the frame the program starts in counts as "main."
+    class Timeline final {
+    public:
+        // Keeps at most [capacity] calls, dropping any after those. Calls shorter than [minimum_call_nanoseconds]
+        //     are left out without counting toward [capacity], so long runs can keep only their slow calls.
+        Timeline(std::size_t capacity, std::int64_t minimum_call_nanoseconds);
+
+        void add_phase(std::string_view name, Time_Point start, std::int64_t duration);
+
+        // Enters "main."
+        void begin(int entry_index);
+        void enter(int entry_index);
+        // Leaves the current function and enters [entry_index] in its place, as "TCALL" does.
+        void tail_call(int entry_index);
+        void leave();
+        // Leaves every function still running, such as when "EXIT" is reached from inside one.
+        // These are kept even past the capacity, so the outermost spans are never missing.
+        void finish();
+
+        std::uint64_t get_dropped_calls() const { return m_dropped_calls; }
+
+        // Functions are given the source line they start at if [lines] has it.
+        void save(std::string_view timeline_file, const Line_Table& lines) const;
+
+        Timeline(const Timeline& other) = delete;
+        Timeline& operator =(const Timeline& other) = delete;
+
+    private:
+        struct Phase {
+            std::string_view name {};
+            Time_Point start {};
+            std::int64_t duration {};
+        };
+
+        struct Call {
+            Time_Point start {};
+            std::int64_t duration {};
+            int entry_index {};
+        };
+
+        std::size_t m_capacity {};
+        std::int64_t m_minimum_call_nanoseconds {};
+        int m_main_entry_index { -1 };
+        std::uint64_t m_dropped_calls {};
+        std::vector<Phase> m_phases {};
+        // In the order they ended.
+        std::vector<Call> m_calls {};
+        // Durations are filled in once they end.
+        std::vector<Call> m_active_calls {};
+
+        void end_call(Time_Point end, bool is_kept_past_capacity);
+    };
+}
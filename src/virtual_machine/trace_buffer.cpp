@@ -0,0 +1,172 @@
+#include "pch.h"
+#include "trace_buffer.h"
+#include "common/logger.h"
+#include "common/error.h"
+
+namespace svim {
+    //----------- Internal Types
+
+    struct Trace_File_Header final {
+        char magic[8] {};
+        std::uint32_t version {};
+        std::uint32_t event_size {};
+        // Events that ran before the first one in the file, which the ring had already overwritten.
+        std::uint64_t skipped_events {};
+        // Bytes of encoded Line_Table between the header and the first event.
+        std::uint64_t line_table_size {};
+    };
+
+
+    //----------- Internal Data
+
+    static constexpr char g_trace_magic[8] { 's', 'v', 'i', 'm', 't', 'r', 'c', '\0' };
+    static constexpr std::uint32_t g_trace_version { 2 };
+    static constexpr std::size_t g_decode_chunk_size { 4096 };
+
+
+    //----------- Helper Functions
+
+    static std::ofstream open_trace_file(std::string_view trace_file, std::uint64_t skipped_events, const Line_Table& lines) {
+        std::ofstream output { std::string(trace_file), std::ios::binary | std::ios::trunc };
+
+        if (!output.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open trace file \"" << trace_file << "\" for writing.";
+            throw File_Open_Failure(message.str());
+        }
+
+        Trace_File_Header header {};
+        std::memcpy(header.magic, g_trace_magic, sizeof(header.magic));
+        header.version = g_trace_version;
+        header.event_size = sizeof(Trace_Event);
+        header.skipped_events = skipped_events;
+        header.line_table_size = lines.get_encoded().size();
+
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char*>(lines.get_encoded().data()), static_cast<std::streamsize>(header.line_table_size));
+        return output;
+    }
+
+
+    //----------- Trace_Buffer
+
+    Trace_Buffer::Trace_Buffer(std::string_view trace_file, std::size_t capacity, bool spill, const Line_Table& lines) :
+        m_trace_file { trace_file },
+        m_lines { lines },
+        m_events((capacity > 0) ? capacity : 1),
+        m_spill { spill }
+    {
+        if (m_spill) {
+            m_spill_output = open_trace_file(m_trace_file, 0, m_lines);
+        }
+    }
+
+    Trace_Buffer::~Trace_Buffer() {
+        try {
+            finish();
+        }
+        catch (...) {}
+    }
+
+    void Trace_Buffer::finish() {
+        if (m_finished) {
+            return;
+        }
+
+        m_finished = true;
+
+        if (m_spill) {
+            write_events(m_spill_output, 0, m_next_slot);
+            m_spill_output.close();
+            return;
+        }
+
+        const std::size_t kept { (m_wrapped) ? m_events.size() : m_next_slot };
+        std::ofstream output { open_trace_file(m_trace_file, m_recorded - kept, m_lines) };
+
+        // Once wrapped, the oldest event sits right where the next one would go.
+        if (m_wrapped) {
+            write_events(output, m_next_slot, m_events.size() - m_next_slot);
+        }
+
+        write_events(output, 0, m_next_slot);
+    }
+
+    void Trace_Buffer::wrap() {
+        m_next_slot = 0;
+        m_wrapped = true;
+
+        if (m_spill) {
+            write_events(m_spill_output, 0, m_events.size());
+        }
+    }
+
+    void Trace_Buffer::write_events(std::ofstream& output, std::size_t first, std::size_t count) const {
+        output.write(reinterpret_cast<const char*>(m_events.data() + first), static_cast<std::streamsize>(count * sizeof(Trace_Event)));
+
+        if (!output) {
+            std::ostringstream message {};
+            message << "Could not write to trace file \"" << m_trace_file << ".\"";
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    void Trace_Buffer::decode(std::string_view trace_file, Logger& logger) {
+        std::ifstream input { std::string(trace_file), std::ios::binary };
+
+        if (!input.is_open()) {
+            std::ostringstream message {};
+            message << "Could not open trace file \"" << trace_file << ".\"";
+            throw File_Open_Failure(message.str());
+        }
+
+        Trace_File_Header header {};
+        input.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (!input ||
+            (std::memcmp(header.magic, g_trace_magic, sizeof(header.magic)) != 0) ||
+            (header.version != g_trace_version) ||
+            (header.event_size != sizeof(Trace_Event))) {
+            std::ostringstream message {};
+            message << "File \"" << trace_file << "\" is not a SVIM trace recorded by this version.";
+            throw std::runtime_error(message.str());
+        }
+
+        // Sizes are checked against the file before anything is allocated for them.
+        input.seekg(0, std::ios::end);
+        const std::uint64_t body_size { static_cast<std::uint64_t>(input.tellg()) - sizeof(header) };
+        input.seekg(sizeof(header), std::ios::beg);
+
+        if (!input || (header.line_table_size > body_size)) {
+            std::ostringstream message {};
+            message << "Trace file \"" << trace_file << "\" ends partway through its line table.";
+            throw std::runtime_error(message.str());
+        }
+
+        if (((body_size - header.line_table_size) % sizeof(Trace_Event)) != 0) {
+            std::ostringstream message {};
+            message << "Trace file \"" << trace_file << "\" ends partway through an event.";
+            throw std::runtime_error(message.str());
+        }
+
+        std::vector<std::uint8_t> encoded_lines(static_cast<std::size_t>(header.line_table_size));
+        input.read(reinterpret_cast<char*>(encoded_lines.data()), static_cast<std::streamsize>(encoded_lines.size()));
+
+        const std::vector<Line_Table::Row> lines { Line_Table(std::move(encoded_lines)).get_rows() };
+
+        if (header.skipped_events > 0) {
+            logger.log_skipped_trace_events(header.skipped_events);
+        }
+
+        std::vector<Trace_Event> events(g_decode_chunk_size);
+
+        while (input) {
+            input.read(reinterpret_cast<char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(Trace_Event)));
+            const std::size_t count { static_cast<std::size_t>(input.gcount()) / sizeof(Trace_Event) };
+
+            for (std::size_t i {}; i < count; ++i) {
+                logger.log_trace_event(events[i], Line_Table::find(lines, events[i].instruction_index));
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "line_table.h"
+
+namespace svim {
+    class Logger;
+
+    // One executed instruction, as recorded by binary trace mode.
+    // Fixed-size and trivially copyable, so recording one is a plain copy into the ring.
+    struct Trace_Event final {
+        static constexpr int s_max_operands { 3 };
+        static constexpr int s_stack_values { 5 };
+
+        std::int32_t instruction_index {};
+        std::int32_t op_code {};
+        std::int32_t operands[s_max_operands] {};
+        // Depths after the instruction ran.
+        std::int32_t stack_depth {};
+        std::int32_t call_depth {};
+        // The top of the stack after the instruction ran, deepest first.
+        // Only the first min(stack_depth, s_stack_values) values are meaningful.
+        std::int32_t stack_top[s_stack_values] {};
+    };
+
+
+    // Ring buffer of the most recent Trace_Events, saved to a binary trace file once tracing finishes.
+    // When spilling, each time the ring fills it is appended to the file instead of overwritten,
+    //     so the file ends up with every event.
+    class Trace_Buffer final {
+    public:
+        // [lines] is saved along with the events, so decoding can name their source lines.
+        Trace_Buffer(std::string_view trace_file, std::size_t capacity, bool spill, const Line_Table& lines);
+        // Finishes the trace file if finish() was not called, such as when the VM unwinds from a fault.
+        ~Trace_Buffer();
+
+        void record(const Trace_Event& event) {
+            m_events[m_next_slot] = event;
+            ++m_recorded;
+
+            if (++m_next_slot == m_events.size()) {
+                wrap();
+            }
+        }
+
+        // Writes out whatever the trace file does not have yet, oldest event first.
+        void finish();
+
+        // Renders [trace_file] through [logger] in the same format as text trace mode.
+        static void decode(std::string_view trace_file, Logger& logger);
+
+        Trace_Buffer(const Trace_Buffer& other) = delete;
+        Trace_Buffer& operator =(const Trace_Buffer& other) = delete;
+
+    private:
+        std::string m_trace_file {};
+        Line_Table m_lines {};
+        std::vector<Trace_Event> m_events {};
+        std::size_t m_next_slot {};
+        std::uint64_t m_recorded {};
+        bool m_wrapped {};
+        bool m_spill {};
+        bool m_finished {};
+        std::ofstream m_spill_output {};
+
+        void wrap();
+        void write_events(std::ofstream& output, std::size_t first, std::size_t count) const;
+    };
+}
@@ -5,6 +5,8 @@
 #include "common/debug.h"
 #include "common/timer.h"
 
+#include <algorithm>
+
 namespace svim {
     //----------- Asserts
 
@@ -91,11 +93,36 @@ if (index >= stack_count) { \
     //----------- Global Values
 
     static constexpr std::size_t g_default_stack_capacity { 100 };
+    // Deep enough for most recursion, so calls rarely have to grow the call stack mid-run.
+    static constexpr std::size_t g_default_call_stack_capacity { 64 };
     static constexpr std::size_t g_default_global_values_capacity { 100 };
     static constexpr auto g_false { 0 };
     static constexpr auto g_true { 1 };
 
 
+    //----------- Helper Functions
+
+    // Rounds toward 0 like "/" by adding (2^shift - 1) to negative dividends before shifting.
+    static int round_for_shift(int dividend, int shift) {
+        return dividend + static_cast<int>(static_cast<unsigned int>(dividend >> 31) >> (32 - shift));
+    }
+
+    // Signed division through a multiply by a precomputed reciprocal ("Hacker's Delight," Chapter 10).
+    static int divide_by_magic(int dividend, int divisor, int magic, int shift) {
+        int quotient { static_cast<int>((static_cast<long long>(magic) * dividend) >> 32) };
+
+        if ((divisor > 0) && (magic < 0)) {
+            quotient += dividend;
+        }
+        else if ((divisor < 0) && (magic > 0)) {
+            quotient -= dividend;
+        }
+
+        quotient >>= shift;
+        return quotient + static_cast<int>(static_cast<unsigned int>(quotient) >> 31);
+    }
+
+
     //----------- Virtual_Machine
 
     Virtual_Machine::Virtual_Machine(std::vector<int>&& parsed_code, int program_starting_line, Logger* logger) :
@@ -103,14 +130,17 @@ if (index >= stack_count) { \
         m_stack(0),
         m_global_values(s_max_global_values),
         m_instruction_index { (program_starting_line >= 0) ? program_starting_line : 0 },
-        m_logger { logger }
+        m_logger { logger },
+        m_output { &m_logger->get_sink() }
     {
         m_stack.reserve(g_default_stack_capacity);
+        m_call_stack.reserve(g_default_call_stack_capacity);
 
         // This frame acts like an impromptu "main()" function.
         // If we "RET" from main_frame, we exit the program entirely.
         Call_Frame main_frame { static_cast<int>(m_code.size()), Call_Frame::s_max_local_values };
-        m_call_stack.push(main_frame);
+        main_frame.entry_index = m_instruction_index;
+        m_call_stack.push_back(main_frame);
 
         SVIM_PRINT_LINE("Virtual machine instantiated.");
         SVIM_PRINT_PROPERTY("Bytecode size", m_code.size());
@@ -128,13 +158,51 @@ if (index >= stack_count) { \
 
         SVIM_PRINT_LINE("Interpreting...");
 
+        if (m_sampling_profiler != nullptr) {
+            m_sampling_profiler->start(m_instrumentation, Instrumentation::sample_requested);
+        }
+
+        if (m_live_metrics != nullptr) {
+            publish_live_metrics(m_instruction_index);
+            m_live_metrics->start(m_instrumentation, Instrumentation::metrics_requested);
+        }
+
+        if (m_call_profile != nullptr) {
+            m_call_profile->begin(m_call_stack.back().entry_index, m_instructions_retired);
+        }
+
+        if (m_timeline != nullptr) {
+            m_timeline->begin(m_call_stack.back().entry_index);
+        }
+
+        try {
+            return execute();
+        }
+        catch (const std::runtime_error& exception) {
+            // Every check runs before its instruction jumps anywhere, so the faulting instruction
+            //     is still the one m_instruction_index last read from.
+            const Source_Location location { get_source_location(m_instruction_index - 1) };
+
+            if (!location.is_known()) {
+                throw;
+            }
+
+            std::ostringstream message {};
+            message << "Line " << location.line << ", column " << location.column << ": " << exception.what();
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    Application::Status Virtual_Machine::execute() {
         while (m_instruction_index < m_code.size()) {
             if (m_trace_mode) {
                 disassemble();
             }
 
+            const int address { m_instruction_index };
             int op_code { m_code.at(m_instruction_index++) };
 
+        dispatch:
             switch (op_code) {
             case Instruction::add:
                 add();
@@ -242,7 +310,7 @@ if (index >= stack_count) { \
 
             case Instruction::print:
                 SVIM_ASSERT_NO_UNDERFLOW(g_print, 1, m_stack.size());
-                m_logger->log_value(pop());
+                m_output->write_value(pop());
                 break;
 
             case Instruction::pop:
@@ -255,6 +323,7 @@ if (index >= stack_count) { \
                 break;
 
             case Instruction::halt:
+                m_output->flush();
                 std::cin.get();
                 break;
 
@@ -263,22 +332,64 @@ if (index >= stack_count) { \
                 call();
                 break;
 
+            case Instruction::tcall:
+                tcall();
+                break;
+
             // This instruction expects any extra values on the stack to be removed.
             case Instruction::ret:
                 ret();
                 break;
 
+            case Instruction::shl:
+                shl();
+                break;
+
+            case Instruction::divp2:
+                divp2();
+                break;
+
+            case Instruction::modp2:
+                modp2();
+                break;
+
+            case Instruction::divm:
+                divm();
+                break;
+
+            case Instruction::modm:
+                modm();
+                break;
+
+            // Runs the replaced instruction as though it had been there all along.
+            case Instruction::trap:
+                op_code = hit_tracepoint(address);
+                goto dispatch;
+
             case Instruction::exit:
+                ++m_instructions_retired;
+
+                if (m_instrumentation.load(std::memory_order_relaxed) != 0) {
+                    record_instrumentation(address, op_code);
+                }
+
                 run_exit_protocol();
                 SVIM_PRINT_LINE("Interpreting complete...");
                 return Application::Status::success;
 
             default:
                 m_logger->output_invalid_op_code(op_code);
+                m_output->flush();
                 SVIM_PRINT_LINE("Interpreting aborted...");
                 return Application::Status::script_execution_failure;
             }
 
+            ++m_instructions_retired;
+
+            if (m_instrumentation.load(std::memory_order_relaxed) != 0) {
+                record_instrumentation(address, op_code);
+            }
+
             if (m_trace_mode) {
                 dump_stack();
                 dump_locals();
@@ -290,12 +401,258 @@ if (index >= stack_count) { \
         return Application::Status::success;
     }
 
+    void Virtual_Machine::set_execution_profile(Execution_Profile* profile) {
+        m_execution_profile = profile;
+        set_instrumentation(Instrumentation::execution_profile, profile != nullptr);
+
+        if (m_execution_profile != nullptr) {
+            m_execution_profile->reset(m_code);
+        }
+    }
+
+    void Virtual_Machine::set_trace_buffer(Trace_Buffer* buffer) {
+        m_trace_buffer = buffer;
+        set_instrumentation(Instrumentation::trace_buffer, buffer != nullptr);
+    }
+
+    void Virtual_Machine::set_execution_stats(Execution_Stats* stats) {
+        m_execution_stats = stats;
+        set_instrumentation(Instrumentation::execution_stats, stats != nullptr);
+    }
+
+    void Virtual_Machine::set_opcode_profile(Opcode_Profile* profile) {
+        m_opcode_profile = profile;
+        set_instrumentation(Instrumentation::opcode_profile, profile != nullptr);
+    }
+
+    void Virtual_Machine::set_coverage(Coverage* coverage) {
+        if (coverage != nullptr) {
+            coverage->reset(m_code);
+        }
+
+        m_coverage_map = (coverage != nullptr) ? coverage->get_map() : nullptr;
+        set_instrumentation(Instrumentation::coverage, coverage != nullptr);
+    }
+
+    void Virtual_Machine::set_instrumentation(Instrumentation instrumentation, bool enabled) {
+        if (enabled) {
+            m_instrumentation.fetch_or(instrumentation, std::memory_order_relaxed);
+        }
+        else {
+            m_instrumentation.fetch_and(~static_cast<unsigned int>(instrumentation), std::memory_order_relaxed);
+        }
+    }
+
+    void Virtual_Machine::record_instrumentation(int address, int op_code) {
+        const unsigned int instrumentation { m_instrumentation.load(std::memory_order_relaxed) };
+
+        if ((instrumentation & Instrumentation::execution_profile) != 0) {
+            record_execution(address, op_code);
+        }
+
+        if ((instrumentation & Instrumentation::trace_buffer) != 0) {
+            record_trace(address, op_code);
+        }
+
+        if ((instrumentation & Instrumentation::execution_stats) != 0) {
+            record_statistics(op_code);
+        }
+
+        if ((instrumentation & Instrumentation::opcode_profile) != 0) {
+            m_opcode_profile->record(op_code);
+        }
+
+        if ((instrumentation & Instrumentation::coverage) != 0) {
+            m_coverage_map[address] = Coverage::s_executed;
+        }
+
+        if ((instrumentation & Instrumentation::sample_requested) != 0) {
+            set_instrumentation(Instrumentation::sample_requested, false);
+            record_sample(address, op_code);
+        }
+
+        if ((instrumentation & Instrumentation::metrics_requested) != 0) {
+            set_instrumentation(Instrumentation::metrics_requested, false);
+            publish_live_metrics(address);
+        }
+    }
+
+    void Virtual_Machine::add_tracepoint(int address) {
+        // Operands can hold any value, including "TRAP," so only instruction boundaries may be patched.
+        const int code_size { static_cast<int>(m_code.size()) };
+        int current {};
+
+        while ((current < address) && (current < code_size)) {
+            const int op_code { m_code[current] };
+
+            if ((op_code < 0) || (op_code >= static_cast<int>(g_instruction_data.size()))) {
+                break;
+            }
+
+            current += 1 + g_instruction_data[op_code].expected_following_values;
+        }
+
+        if ((current != address) || (address >= code_size)) {
+            std::ostringstream message {};
+            message << "Cannot set tracepoint at index " << address << ", which is not the start of an instruction.";
+            throw std::runtime_error(message.str());
+        }
+
+        if (m_code[address] == Instruction::trap) {
+            return;
+        }
+
+        m_tracepoints[address] = Tracepoint { m_code[address] };
+        m_code[address] = Instruction::trap;
+    }
+
+    int Virtual_Machine::hit_tracepoint(int address) {
+        Tracepoint& tracepoint { m_tracepoints.at(address) };
+        ++tracepoint.hits;
+
+        m_logger->log_tracepoint(address, tracepoint.hits);
+
+        // Trace mode already printed the instruction.
+        if (!m_trace_mode) {
+            m_logger->log_instruction(address, m_code, tracepoint.op_code, get_source_location(address));
+            dump_stack();
+            dump_locals();
+        }
+
+        return tracepoint.op_code;
+    }
+
+    Source_Location Virtual_Machine::get_source_location(int address) const {
+        return (m_line_table != nullptr) ? m_line_table->find(address) : Source_Location {};
+    }
+
+    int Virtual_Machine::get_original_op_code(int address) const {
+        const int op_code { m_code.at(address) };
+
+        if (op_code != Instruction::trap) {
+            return op_code;
+        }
+
+        return m_tracepoints.at(address).op_code;
+    }
+
+    // Branch directions go in the byte of the branch's operand, and are only recorded while coverage is.
+    void Virtual_Machine::record_branch(int operand_address, std::uint8_t direction) {
+        if (m_coverage_map != nullptr) {
+            m_coverage_map[operand_address] |= direction;
+        }
+    }
+
+    void Virtual_Machine::record_execution(int address, int op_code) {
+        m_execution_profile->record_execution(address);
+
+        // Conditional branches fall through to the instruction right after their operand.
+        if (((op_code == Instruction::brt) || (op_code == Instruction::brf)) && (m_instruction_index != (address + 2))) {
+            m_execution_profile->record_taken_branch(address);
+        }
+    }
+
+    void Virtual_Machine::record_trace(int address, int op_code) {
+        Trace_Event event { address, op_code };
+
+        for (int i {}; i < g_instruction_data[op_code].expected_following_values; ++i) {
+            event.operands[i] = m_code[address + 1 + i];
+        }
+
+        const std::size_t depth { m_stack.size() };
+        const std::size_t shown { (depth < Trace_Event::s_stack_values) ? depth : Trace_Event::s_stack_values };
+
+        event.stack_depth = static_cast<std::int32_t>(depth);
+        event.call_depth = static_cast<std::int32_t>(m_call_stack.size());
+        std::copy(m_stack.end() - shown, m_stack.end(), event.stack_top);
+
+        m_trace_buffer->record(event);
+    }
+
+    void Virtual_Machine::record_statistics(int op_code) {
+        Execution_Stats& stats { *m_execution_stats };
+
+        if ((op_code == Instruction::call) || (op_code == Instruction::tcall)) {
+            ++stats.calls;
+        }
+
+        stats.peak_stack_depth = std::max(stats.peak_stack_depth, m_stack.size());
+        stats.peak_call_depth = std::max(stats.peak_call_depth, m_call_stack.size());
+    }
+
+    // Attributed to the instruction that just ran, which is the one the timer interrupted.
+    void Virtual_Machine::record_sample(int address, int op_code) {
+        // Returning from the starting frame ends the program, leaving nothing to attribute the sample to.
+        if (m_call_stack.empty()) {
+            return;
+        }
+
+        m_sampled_functions.clear();
+
+        for (const Call_Frame& frame : m_call_stack) {
+            m_sampled_functions.push_back(frame.entry_index);
+        }
+
+        m_sampling_profiler->record(m_sampled_functions, address, op_code);
+    }
+
+    void Virtual_Machine::publish_live_metrics(int address) {
+        if (m_live_metrics == nullptr) {
+            return;
+        }
+
+        m_live_metrics->publish({
+            m_instructions_retired,
+            m_stack.size(),
+            m_call_stack.size(),
+            m_output->get_bytes_written(),
+            address
+        });
+    }
+
     void Virtual_Machine::dump_stack() const {
         m_logger->log_stack(m_stack);
     }
 
+    Memory_Report Virtual_Machine::get_memory_report() const {
+        Memory_Report report {};
+        report.machine_bytes = sizeof(Virtual_Machine);
+        report.code_bytes = m_code.capacity() * sizeof(int);
+        report.stack_capacity = m_stack.capacity();
+        report.stack_bytes = m_stack.capacity() * sizeof(int);
+        report.call_stack_capacity = m_call_stack.capacity();
+        report.call_stack_bytes = m_call_stack.capacity() * sizeof(Call_Frame);
+        report.global_values = m_global_values.capacity();
+        report.global_bytes = m_global_values.capacity() * sizeof(int);
+        report.output_buffer_bytes = m_output->get_buffer_bytes();
+
+        // Each tracepoint is a hash node holding its entry and a link, along with its share of the bucket array.
+        report.instrumentation_bytes =
+            m_sampled_functions.capacity() * sizeof(int) +
+            m_tracepoints.size() * (sizeof(std::pair<const int, Tracepoint>) + sizeof(void*)) +
+            m_tracepoints.bucket_count() * sizeof(void*);
+
+        for (std::size_t address {}; address < m_code.size();) {
+            const int op_code { get_original_op_code(static_cast<int>(address)) };
+
+            if ((op_code < 0) || (static_cast<std::size_t>(op_code) >= g_instruction_data.size())) {
+                break;
+            }
+
+            const bool names_global { (op_code == Instruction::gpush) || (op_code == Instruction::gstore) };
+
+            if (names_global && ((address + 1) < m_code.size()) && (m_code[address + 1] >= 0)) {
+                report.globals_referenced = std::max(report.globals_referenced, static_cast<std::size_t>(m_code[address + 1]) + 1);
+            }
+
+            address += 1 + g_instruction_data[op_code].expected_following_values;
+        }
+
+        return report;
+    }
+
     void Virtual_Machine::disassemble() const {
-        m_logger->log_instruction(m_instruction_index, m_code, m_code.at(m_instruction_index));
+        m_logger->log_instruction(m_instruction_index, m_code, get_original_op_code(m_instruction_index), get_source_location(m_instruction_index));
     }
 
     void Virtual_Machine::dump_globals() const {
@@ -303,12 +660,32 @@ if (index >= stack_count) { \
     }
 
     void Virtual_Machine::dump_locals() const {
-        const Call_Frame& current { m_call_stack.top() };
+        const Call_Frame& current { m_call_stack.back() };
         m_logger->log_local_data(current.local_values, Call_Frame::s_max_local_values);
     }
 
     void Virtual_Machine::dump_bytecode() const {
-        m_logger->log_compiled_source_code(m_code);
+        if (m_tracepoints.empty()) {
+            m_logger->log_compiled_source_code(m_code);
+            dump_line_table();
+            return;
+        }
+
+        // Shows the program as it was given, without the "TRAP"s written over it.
+        std::vector<int> code { m_code };
+
+        for (const auto& [address, tracepoint] : m_tracepoints) {
+            code[address] = tracepoint.op_code;
+        }
+
+        m_logger->log_compiled_source_code(code);
+        dump_line_table();
+    }
+
+    void Virtual_Machine::dump_line_table() const {
+        if ((m_line_table != nullptr) && !m_line_table->empty()) {
+            m_logger->log_line_table(*m_line_table);
+        }
     }
 
     void Virtual_Machine::add() {
@@ -412,31 +789,41 @@ if (index >= stack_count) { \
     }
 
     void Virtual_Machine::brt() {
+        const int operand_address { m_instruction_index };
         int address { next_instruction() };
         SVIM_ASSERT_WITHIN_CODE_RANGE(g_call, address, m_code.size());
 
         SVIM_ASSERT_NO_UNDERFLOW(g_branch_if_true, 1, m_stack.size());
 
         if (pop() != g_false) {
+            record_branch(operand_address, Coverage::s_taken);
             jump_to(address);
         }
+        else {
+            record_branch(operand_address, Coverage::s_fell_through);
+        }
     }
 
     void Virtual_Machine::brf() {
+        const int operand_address { m_instruction_index };
         int address { next_instruction() };
         SVIM_ASSERT_WITHIN_CODE_RANGE(g_call, address, m_code.size());
 
         SVIM_ASSERT_NO_UNDERFLOW(g_branch_if_false, 1, m_stack.size());
 
         if (pop() == g_false) {
+            record_branch(operand_address, Coverage::s_taken);
             jump_to(address);
         }
+        else {
+            record_branch(operand_address, Coverage::s_fell_through);
+        }
     }
 
     void Virtual_Machine::lpush() {
         int index { next_instruction() };
         SVIM_ASERT_WITHIN_LOCALS_RANGE(g_local_push, index, Call_Frame::s_max_local_values);
-        push(m_call_stack.top().local_values[index]);
+        push(m_call_stack.back().local_values[index]);
     }
 
     void Virtual_Machine::gpush() {
@@ -450,7 +837,7 @@ if (index >= stack_count) { \
         int index { next_instruction() };
 
         SVIM_ASERT_WITHIN_LOCALS_RANGE(g_local_store, index, Call_Frame::s_max_local_values);
-        m_call_stack.top().local_values[index] = pop();
+        m_call_stack.back().local_values[index] = pop();
     }
 
     void Virtual_Machine::gstore() {
@@ -514,20 +901,106 @@ if (index >= stack_count) { \
             new_frame.local_values[i] = pop();
         }
 
-        m_call_stack.push(new_frame);
+        new_frame.entry_index = destination_index;
+        m_call_stack.push_back(new_frame);
+        jump_to(destination_index);
+
+        // Plus 1 so this "CALL" counts toward the caller, which has yet to have it counted.
+        if (m_call_profile != nullptr) {
+            m_call_profile->enter(destination_index, m_instructions_retired + 1);
+        }
+
+        if (m_timeline != nullptr) {
+            m_timeline->enter(destination_index);
+        }
+    }
+
+    void Virtual_Machine::tcall() {
+        int destination_index { next_instruction() };
+        SVIM_ASSERT_WITHIN_CODE_RANGE(g_tail_call, destination_index, m_code.size());
+
+        int arg_count { next_instruction() };
+        SVIM_ASSERT_NO_UNDERFLOW(g_tail_call, arg_count, m_stack.size());
+
+        // The callee inherits our return point, so a later "RET" skips straight past our own.
+        Call_Frame& current { m_call_stack.back() };
+        current = Call_Frame { current.return_index };
+        current.entry_index = destination_index;
+
+        for (int i {}; i < arg_count; ++i) {
+            current.local_values[i] = pop();
+        }
+
         jump_to(destination_index);
+
+        if (m_call_profile != nullptr) {
+            m_call_profile->tail_call(destination_index, m_instructions_retired + 1);
+        }
+
+        if (m_timeline != nullptr) {
+            m_timeline->tail_call(destination_index);
+        }
     }
 
     void Virtual_Machine::ret() {
-        jump_to(m_call_stack.top().return_index);
-        m_call_stack.pop();
+        jump_to(m_call_stack.back().return_index);
+        m_call_stack.pop_back();
+
+        // Plus 1 so this "RET" counts toward the function it returns from.
+        if (m_call_profile != nullptr) {
+            m_call_profile->leave(m_instructions_retired + 1);
+        }
+
+        if (m_timeline != nullptr) {
+            m_timeline->leave();
+        }
+    }
+
+    void Virtual_Machine::shl() {
+        SVIM_ASSERT_NO_UNDERFLOW(g_shift_left, 1, m_stack.size());
+        int shift { next_instruction() };
+        m_stack.back() = static_cast<int>(static_cast<unsigned int>(m_stack.back()) << shift);
+    }
+
+    void Virtual_Machine::divp2() {
+        SVIM_ASSERT_NO_UNDERFLOW(g_div_power_of_two, 1, m_stack.size());
+        int shift { next_instruction() };
+        m_stack.back() = round_for_shift(m_stack.back(), shift) >> shift;
+    }
+
+    void Virtual_Machine::modp2() {
+        SVIM_ASSERT_NO_UNDERFLOW(g_mod_power_of_two, 1, m_stack.size());
+        int shift { next_instruction() };
+        int dividend { m_stack.back() };
+        unsigned int truncated { static_cast<unsigned int>(round_for_shift(dividend, shift) >> shift) << shift };
+        m_stack.back() = static_cast<int>(static_cast<unsigned int>(dividend) - truncated);
+    }
+
+    void Virtual_Machine::divm() {
+        SVIM_ASSERT_NO_UNDERFLOW(g_div_magic, 1, m_stack.size());
+        int divisor { next_instruction() };
+        int magic { next_instruction() };
+        int shift { next_instruction() };
+        m_stack.back() = divide_by_magic(m_stack.back(), divisor, magic, shift);
     }
 
-    void Virtual_Machine::run_exit_protocol() const {
+    void Virtual_Machine::modm() {
+        SVIM_ASSERT_NO_UNDERFLOW(g_mod_magic, 1, m_stack.size());
+        int divisor { next_instruction() };
+        int magic { next_instruction() };
+        int shift { next_instruction() };
+        int dividend { m_stack.back() };
+        int quotient { divide_by_magic(dividend, divisor, magic, shift) };
+        m_stack.back() = static_cast<int>(static_cast<unsigned int>(dividend) - (static_cast<unsigned int>(quotient) * static_cast<unsigned int>(divisor)));
+    }
+
+    void Virtual_Machine::run_exit_protocol() {
         if (m_trace_mode) {
             dump_stack();
             dump_globals();
             dump_locals();
         }
+
+        m_output->flush();
     }
 }
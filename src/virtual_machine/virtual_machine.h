@@ -3,10 +3,22 @@
 #include <string>
 #include <string_view>
 #include <vector>
-#include <stack>
 #include <memory>
+#include <atomic>
+#include <unordered_map>
 #include "interpreter/application.h"
 #include "common/logger.h"
+#include "execution_profile.h"
+#include "execution_stats.h"
+#include "memory_report.h"
+#include "opcode_profile.h"
+#include "sampling_profiler.h"
+#include "live_metrics.h"
+#include "call_profile.h"
+#include "timeline.h"
+#include "trace_buffer.h"
+#include "line_table.h"
+#include "coverage.h"
 
 namespace svim {
     class Virtual_Machine final {
@@ -16,6 +28,14 @@ namespace svim {
 
             int return_index {};
             int local_values[s_max_local_values] {};
+            // Where the function this frame belongs to starts.
+            int entry_index {};
+        };
+
+        struct Tracepoint {
+            // The instruction "TRAP" was written over.
+            int op_code {};
+            std::uint64_t hits {};
         };
 
     public:
@@ -25,31 +45,105 @@ namespace svim {
         static constexpr int get_max_local_values() { return Call_Frame::s_max_local_values; }
 
         void set_trace_mode(bool enabled) { m_trace_mode = enabled; }
+        // Counts executions of every address into [profile], which must outlive interpret().
+        void set_execution_profile(Execution_Profile* profile);
+        // Records every executed instruction into [buffer], which must outlive interpret().
+        void set_trace_buffer(Trace_Buffer* buffer);
+        // Counts into [stats], which must outlive interpret().
+        void set_execution_stats(Execution_Stats* stats);
+        // Counts executed opcodes into [profile], which must outlive interpret().
+        void set_opcode_profile(Opcode_Profile* profile);
+        // Marks every executed instruction and branch direction in [coverage], which must outlive interpret().
+        // Set it before adding tracepoints, as it is bound to the bytecode as it stands.
+        // Passing nullptr stops recording.
+        void set_coverage(Coverage* coverage);
+        // Starts [profiler]'s timer once interpret() begins, sampling on every tick until it is stopped.
+        // [profiler] must outlive interpret().
+        void set_sampling_profiler(Sampling_Profiler* profiler) { m_sampling_profiler = profiler; }
+        // Tracks the cost of every function through "CALL," "TCALL," and "RET" into [profile],
+        //     which must outlive interpret(). Call Call_Profile::finish() once interpret() returns.
+        void set_call_profile(Call_Profile* profile) { m_call_profile = profile; }
+        // Records a span for every function call into [timeline], which must outlive interpret().
+        // Call Timeline::finish() once interpret() returns.
+        void set_timeline(Timeline* timeline) { m_timeline = timeline; }
+        // Starts [metrics]' timer once interpret() begins, publishing the machine's counters on every tick.
+        // [metrics] must outlive interpret(). Call publish_live_metrics() once interpret() returns for the final values.
+        void set_live_metrics(Live_Metrics* metrics) { m_live_metrics = metrics; }
+        // Lets errors, trace mode, and tracepoints name the source lines of instructions.
+        // [lines] must outlive interpret() and match the bytecode given to the constructor.
+        void set_line_table(const Line_Table* lines) { m_line_table = lines; }
+        // Logs the machine's state every time the instruction at [address] is about to run.
+        // Throws if [address] is not the start of an instruction.
+        void add_tracepoint(int address);
 
         Application::Status interpret();
 
         void dump_bytecode() const;
+        void publish_live_metrics() { publish_live_metrics(m_instruction_index); }
+
+        std::uint64_t get_output_bytes() const { return m_output->get_bytes_written(); }
+        // Counted whether or not any instrumentation is enabled; an increment per instruction costs next to nothing.
+        std::uint64_t get_instructions_retired() const { return m_instructions_retired; }
+        // Walks the code to find the globals it names, so call it once a run ends rather than while one is going.
+        Memory_Report get_memory_report() const;
 
         Virtual_Machine(const Virtual_Machine& other) = delete;
         Virtual_Machine& operator =(const Virtual_Machine& other) = delete;
 
     private:
+        // Everything recording each executed instruction, so the interpreting loop checks them all at once.
+        enum Instrumentation : unsigned int {
+            execution_profile   = 1 << 0,
+            trace_buffer        = 1 << 1,
+            execution_stats     = 1 << 2,
+            opcode_profile      = 1 << 3,
+            // Set by Sampling_Profiler's timer and cleared once the sample is taken.
+            sample_requested    = 1 << 4,
+            // Set by Live_Metrics' timer and cleared once the counters are published.
+            metrics_requested   = 1 << 5,
+            coverage            = 1 << 6
+        };
+
         inline static constexpr int s_max_global_values { 100 };
 
         std::vector<int> m_code {};
         std::vector<int> m_stack {};
         std::vector<int> m_global_values {};
-        std::stack<Call_Frame> m_call_stack {};
+        std::vector<Call_Frame> m_call_stack {};
 
         int m_instruction_index {};
+        std::uint64_t m_instructions_retired {};
 
         std::unique_ptr<Logger> m_logger {};
+        // Cached from m_logger so "PRINT" skips its virtual functions.
+        Output_Sink* m_output {};
         bool m_trace_mode {};
+        Execution_Profile* m_execution_profile {};
+        Trace_Buffer* m_trace_buffer {};
+        Execution_Stats* m_execution_stats {};
+        Opcode_Profile* m_opcode_profile {};
+        Sampling_Profiler* m_sampling_profiler {};
+        Call_Profile* m_call_profile {};
+        Timeline* m_timeline {};
+        Live_Metrics* m_live_metrics {};
+        // The map of the Coverage being recorded into, if any.
+        std::uint8_t* m_coverage_map {};
+        const Line_Table* m_line_table {};
+        // Reused between samples so taking one does not allocate.
+        std::vector<int> m_sampled_functions {};
+        // Bits of Instrumentation that are enabled. Atomic since Sampling_Profiler's signal handler
+        //     and Live_Metrics' thread set bits in it.
+        std::atomic<unsigned int> m_instrumentation {};
+        // Keyed by address. Only "TRAP" looks these up, so the rest of the code pays nothing for them.
+        std::unordered_map<int, Tracepoint> m_tracepoints {};
+
+        Application::Status execute();
 
         void disassemble() const;
         void dump_globals() const;
         void dump_locals() const;
         void dump_stack() const;
+        void dump_line_table() const;
 
         void add();
         void sub();
@@ -82,8 +176,25 @@ namespace svim {
         int next_instruction() { return m_code[m_instruction_index++]; }
         void jump_to(int address) { m_instruction_index = address; }
         void call();
+        void tcall();
         void ret();
-
-        void run_exit_protocol() const;
+        void shl();
+        void divp2();
+        void modp2();
+        void divm();
+        void modm();
+
+        void set_instrumentation(Instrumentation instrumentation, bool enabled);
+        void record_instrumentation(int address, int op_code);
+        void record_execution(int address, int op_code);
+        void record_trace(int address, int op_code);
+        void record_statistics(int op_code);
+        void record_branch(int operand_address, std::uint8_t direction);
+        void record_sample(int address, int op_code);
+        void publish_live_metrics(int address);
+        int hit_tracepoint(int address);
+        int get_original_op_code(int address) const;
+        Source_Location get_source_location(int address) const;
+        void run_exit_protocol();
     };
 }
@@ -37,6 +37,29 @@ namespace test {
         create_and_run_app("Run_To_Console", argv, 3);
     }
 
+    void run_program_with_stats() {
+        const char* argv[] { g_executable_name, "-e", "fibonacci_10", "--stats" };
+        create_and_run_app("Run_With_Stats", argv, 4);
+
+        const char* json_argv[] { g_executable_name, "-e", "fibonacci_10", "--stats-json" };
+        create_and_run_app("Run_With_Stats_Json", json_argv, 4);
+    }
+
+    void benchmark_program() {
+        // Source files given on the command line must be in the working directory.
+        {
+            std::ofstream source { "test_benchmark.svim" };
+            source << ".INIT\nPUSH 8\nPUSH 7\nADD\nPRINT\nEXIT\n";
+        }
+
+        const char* argv[] { g_executable_name, "-b", "test_benchmark.svim", "--runs=3", "--save-baseline=test_benchmark.json" };
+        create_and_run_app("Benchmark", argv, 5);
+
+        // Generous enough that timing noise between the two runs never counts as a regression.
+        const char* compare_argv[] { g_executable_name, "-b", "test_benchmark.svim", "--runs=3", "--baseline=test_benchmark.json", "--max-regression=1000" };
+        create_and_run_app("Benchmark_Against_Baseline", compare_argv, 6);
+    }
+
     void run_program_to_file() {
         const char* argv[] { g_executable_name,  "-f", g_test_file_1.data() };
         create_and_run_app("Run_To_File", argv, 3);
@@ -3,6 +3,8 @@
 namespace test {
     void print_help();
     void run_program_to_console();
+    void run_program_with_stats();
+    void benchmark_program();
     void run_program_to_file();
     void dump_code_to_file();
     void run_example_program();
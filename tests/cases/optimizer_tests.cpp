@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "optimizer_tests.h"
+#include "virtual_machine/optimizer.h"
+#include "virtual_machine/virtual_machine.h"
+#include "virtual_machine/instructions.h"
+#include "interpreter/application.h"
+#include "interpreter/program.h"
+
+namespace test {
+    using namespace svim;
+
+    static void run_optimized(std::string_view name, std::vector<int>&& bytecode, int starting_index, Optimizer::Settings settings = {}) {
+        try {
+            std::cout << "\n---------- " << name << '\n';
+            std::cout << "Bytecode size before optimizing: " << bytecode.size() << '\n';
+
+            Optimizer optimizer { std::move(bytecode), starting_index, settings };
+            std::vector<int> optimized { optimizer.optimize() };
+
+            std::cout << "Bytecode size after optimizing: " << optimized.size() << '\n';
+
+            Virtual_Machine vm { std::move(optimized), optimizer.get_program_start_index(), new Console_Logger() };
+            Application::Status result { vm.interpret() };
+            std::cout << "Program result: " << static_cast<int>(result) << '\n';
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void run_tail_calls() {
+        // Accumulator-style recursion; without tail calls, this grows the call stack by 50000 frames.
+        run_optimized("tail_calls", std::vector<int> {
+            // FUNCTION: main()
+            Instruction::push, 0,            // 0, 1     (acc)
+            Instruction::push, 50000,        // 2, 3     (n)
+            Instruction::call, 9, 2,         // 4, 5, 6
+            Instruction::print,              // 7        (1250025000)
+            Instruction::exit,               // 8
+
+            // FUNCTION: sum(n, acc)
+            Instruction::lpush, 0,           // 9, 10
+            Instruction::brt, 16,            // 11, 12
+            Instruction::lpush, 1,           // 13, 14
+            Instruction::ret,                // 15
+            // return sum(n - 1, acc + n)
+            Instruction::lpush, 1,           // 16, 17
+            Instruction::lpush, 0,           // 18, 19
+            Instruction::add,                // 20
+            Instruction::lpush, 0,           // 21, 22
+            Instruction::dec,                // 23
+            Instruction::call, 9, 2,         // 24, 25, 26
+            Instruction::ret,                // 27
+        }, 0);
+    }
+
+    void run_unrolled_loops() {
+        // Both counted loop shapes: "loop" tests at the bottom, while "factorial_5" tests at the top.
+        // The factorial call would otherwise be evaluated away entirely.
+        Optimizer::Settings settings {};
+        settings.constant_calls = false;
+
+        for (std::string_view name : { "loop", "factorial_5" }) {
+            const Program* program { get_demo_program(name) };
+            std::vector<int> bytecode { program->bytecode };
+            run_optimized(program->name, std::move(bytecode), program->starting_point, settings);
+        }
+    }
+
+    void run_unrolled_loop_bounds() {
+        // The bound sits right below INT_MAX, so checking ahead for a full unrolled group must not wrap the counter.
+        Optimizer::Settings settings {};
+        settings.constant_calls = false;
+
+        run_optimized("unrolled_loop_bounds", std::vector<int> {
+            // FUNCTION: main()
+            Instruction::push, 2147483647,  // 0, 1       (bound)
+            Instruction::push, 2147483645,  // 2, 3       (i)
+            Instruction::call, 8, 2,        // 4, 5, 6
+            Instruction::exit,              // 7
+
+            // FUNCTION: count(i, bound)
+            // count = 0
+            Instruction::push, 0,           // 8, 9
+            Instruction::lstore, 2,         // 10, 11
+            // i < bound
+            Instruction::lpush, 0,          // 12, 13
+            Instruction::lpush, 1,          // 14, 15
+            Instruction::lt,                // 16
+            Instruction::brf, 31,           // 17, 18
+            // ++count
+            Instruction::lpush, 2,          // 19, 20
+            Instruction::inc,               // 21
+            Instruction::lstore, 2,         // 22, 23
+            // ++i
+            Instruction::lpush, 0,          // 24, 25
+            Instruction::inc,               // 26
+            Instruction::lstore, 0,         // 27, 28
+            Instruction::br, 12,            // 29, 30
+            // print(count), print(i)
+            Instruction::lpush, 2,          // 31, 32
+            Instruction::print,             // 33     (2)
+            Instruction::lpush, 0,          // 34, 35
+            Instruction::print,             // 36     (2147483647)
+            Instruction::ret,               // 37
+        }, 0, settings);
+
+        // With a constant bound, the guard compares against "bound - guard_offset," which here is one past INT_MAX.
+        settings.unroll_factor = 2;
+
+        run_optimized("unrolled_loop_bounds (constant)", std::vector<int> {
+            // FUNCTION: main()
+            Instruction::push, 2147483645,  // 0, 1       (i)
+            Instruction::call, 6, 1,        // 2, 3, 4
+            Instruction::exit,              // 5
+
+            // FUNCTION: count_down(i)
+            // DO-WHILE (i >= 2147483645)
+            Instruction::lpush, 0,          // 6, 7
+            Instruction::push, 3,           // 8, 9
+            Instruction::sub,               // 10
+            Instruction::lstore, 0,         // 11, 12
+            Instruction::lpush, 0,          // 13, 14
+            Instruction::push, 2147483645,  // 15, 16
+            Instruction::geq,               // 17
+            Instruction::brt, 6,            // 18, 19
+            // print(i)
+            Instruction::lpush, 0,          // 20, 21
+            Instruction::print,             // 22     (2147483642)
+            Instruction::ret,               // 23
+        }, 0, settings);
+    }
+
+    void run_constant_calls() {
+        run_optimized("constant_calls", std::vector<int> {
+            // FUNCTION: main()
+            Instruction::push, 10,          // 0, 1
+            Instruction::call, 12, 1,       // 2, 3, 4     (PUSH 55)
+            Instruction::print,             // 5           (55)
+            Instruction::push, 3,           // 6, 7
+            Instruction::call, 38, 1,       // 8, 9, 10    (kept, as show() prints)
+            Instruction::exit,              // 11
+
+            // FUNCTION: fibonacci(n)
+            Instruction::lpush, 0,          // 12, 13
+            Instruction::push, 2,           // 14, 15
+            Instruction::lt,                // 16
+            Instruction::brf, 22,           // 17, 18
+            Instruction::lpush, 0,          // 19, 20
+            Instruction::ret,               // 21
+            // return fibonacci(n - 1) + fibonacci(n - 2)
+            Instruction::lpush, 0,          // 22, 23
+            Instruction::dec,               // 24
+            Instruction::call, 12, 1,       // 25, 26, 27
+            Instruction::lpush, 0,          // 28, 29
+            Instruction::push, 2,           // 30, 31
+            Instruction::sub,               // 32
+            Instruction::call, 12, 1,       // 33, 34, 35
+            Instruction::add,               // 36
+            Instruction::ret,               // 37
+
+            // FUNCTION: show(n)
+            Instruction::lpush, 0,          // 38, 39
+            Instruction::print,             // 40      (3)
+            Instruction::ret,               // 41
+        }, 0);
+    }
+
+    void run_strength_reduction() {
+        run_optimized("strength_reduction", std::vector<int> {
+            Instruction::push, -100,
+            Instruction::push, 8,
+            Instruction::mul,           // SHL 3
+            Instruction::print,         // -800
+            Instruction::push, -100,
+            Instruction::push, 8,
+            Instruction::div,           // DIVP2 3
+            Instruction::print,         // -12
+            Instruction::push, -100,
+            Instruction::push, 8,
+            Instruction::mod,           // MODP2 3
+            Instruction::print,         // -4
+            Instruction::push, 1000,
+            Instruction::push, 7,
+            Instruction::div,           // DIVM
+            Instruction::print,         // 142
+            Instruction::push, -1000,
+            Instruction::push, -7,
+            Instruction::mod,           // MODM
+            Instruction::print,         // -6
+            Instruction::exit,
+        }, 0);
+    }
+
+    void run_block_layout() {
+        for (std::string_view name : { "branches", "fibonacci_10" }) {
+            const Program* program { get_demo_program(name) };
+
+            try {
+                std::cout << "\n---------- " << program->name << " (profile-guided)\n";
+
+                std::vector<int> bytecode { program->bytecode };
+                Optimizer recording_optimizer { std::move(bytecode), program->starting_point, {} };
+                std::vector<int> recorded { recording_optimizer.optimize() };
+
+                Execution_Profile profile {};
+                Virtual_Machine recording_vm { std::move(recorded), recording_optimizer.get_program_start_index(), new Console_Logger() };
+                recording_vm.set_execution_profile(&profile);
+                recording_vm.interpret();
+
+                Optimizer::Settings settings {};
+                settings.profile = &profile;
+
+                bytecode = program->bytecode;
+                Optimizer optimizer { std::move(bytecode), program->starting_point, settings };
+                std::vector<int> optimized { optimizer.optimize() };
+                std::cout << "Profile applied: " << std::boolalpha << optimizer.is_profile_applied() << '\n';
+
+                Virtual_Machine vm { std::move(optimized), optimizer.get_program_start_index(), new Console_Logger() };
+                Application::Status result { vm.interpret() };
+                std::cout << "Program result: " << static_cast<int>(result) << '\n';
+            }
+            catch (const std::exception& exception) {
+                std::cout << exception.what() << '\n';
+            }
+        }
+    }
+
+    void map_line_table() {
+        const Program* program { get_demo_program("loop") };
+
+        try {
+            std::cout << "\n---------- " << program->name << '\n';
+
+            // As though every instruction had been written on its own line.
+            Line_Table lines {};
+            int line { 1 };
+
+            for (std::size_t address {}; address < program->bytecode.size(); ++line) {
+                lines.add(static_cast<int>(address), { line, 1 });
+                address += 1 + g_instruction_data[program->bytecode[address]].expected_following_values;
+            }
+
+            const Line_Table decoded { std::vector<std::uint8_t> { lines.get_encoded() } };
+
+            std::cout
+                << "Rows: " << lines.get_rows().size() << " in " << lines.get_encoded().size() << " bytes\n"
+                << "Decodes the same: " << std::boolalpha << (decoded.get_encoded() == lines.get_encoded()) << '\n';
+
+            std::vector<int> bytecode { program->bytecode };
+            Optimizer optimizer { std::move(bytecode), program->starting_point, {} };
+            const std::vector<int> optimized { optimizer.optimize() };
+            const Line_Table mapped { optimizer.map_line_table(lines) };
+
+            std::cout << "Optimized rows:\n";
+
+            for (const Line_Table::Row& row : mapped.get_rows()) {
+                std::cout
+                    << "    Index " << row.address << ": " << g_instruction_data[optimized[row.address]].name
+                    << ", line " << row.location.line << '\n';
+            }
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+}
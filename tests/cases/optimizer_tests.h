@@ -0,0 +1,11 @@
+#pragma once
+
+namespace test {
+    void run_tail_calls();
+    void run_unrolled_loops();
+    void run_unrolled_loop_bounds();
+    void run_constant_calls();
+    void run_strength_reduction();
+    void run_block_layout();
+    void map_line_table();
+}
@@ -2,6 +2,8 @@
 #include "virtual_machine_tests.h"
 #include "virtual_machine/virtual_machine.h"
 #include "virtual_machine/instructions.h"
+#include "virtual_machine/trace_buffer.h"
+#include "common/allocation_counter.h"
 #include "interpreter/application.h"
 #include "interpreter/program.h"
 
@@ -59,7 +61,7 @@ namespace test {
         }
     }
 
-    static void dump_to_file(const Program* p_program, std::string_view output_file) {
+    static void dump_to_file(const Program* p_program, std::string_view output_file, File_Output_Mode mode = File_Output_Mode::direct) {
         if (p_program == nullptr) {
             std::cerr << "Valid program not given. Cannot run dump program to file.\n";
             return;
@@ -71,7 +73,7 @@ namespace test {
         int starting_index { program.starting_point };
 
         try {
-            Virtual_Machine vm { std::move(bytecode), 0, new File_Logger(output_file) };
+            Virtual_Machine vm { std::move(bytecode), 0, new File_Logger(output_file, mode) };
             vm.set_trace_mode(true);
             Application::Status result { vm.interpret() };
             print_program(result);
@@ -110,6 +112,275 @@ namespace test {
         dump_to_file(get_demo_program(3), test_output);
     }
 
+    void output_to_file_async() {
+        constexpr std::string_view test_output { "test_dump_async.txt" };
+        dump_to_file(get_demo_program(5), test_output, File_Output_Mode::asynchronous);
+    }
+
+    void output_to_file_mapped() {
+        constexpr std::string_view test_output { "test_dump_mapped.txt" };
+        dump_to_file(get_demo_program(5), test_output, File_Output_Mode::mapped);
+    }
+
+    void trace_to_file() {
+        constexpr std::string_view test_trace { "test_trace.bin" };
+        const Program& program { *get_demo_program(5) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+
+            {
+                // Small enough that the ring wraps, so the decoded trace starts partway through.
+                Trace_Buffer trace { test_trace, 16, false, Line_Table {} };
+                Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+                vm.set_trace_mode(false);
+                vm.set_trace_buffer(&trace);
+                print_program(vm.interpret());
+                trace.finish();
+            }
+
+            Console_Logger logger {};
+            Trace_Buffer::decode(test_trace, logger);
+            logger.flush();
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+
+        try {
+            // Claims a line table far larger than the file, so this should be rejected before anything is allocated for it.
+            std::fstream file { std::string(test_trace), std::ios::binary | std::ios::in | std::ios::out };
+            const std::uint64_t line_table_size { std::numeric_limits<std::uint64_t>::max() / 2 };
+            // The header field holding the line table size starts 24 bytes into the file.
+            file.seekp(24);
+            file.write(reinterpret_cast<const char*>(&line_table_size), sizeof(line_table_size));
+            file.close();
+
+            Console_Logger logger {};
+            Trace_Buffer::decode(test_trace, logger);
+            logger.flush();
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void run_tracepoints() {
+        const Program& program { *get_demo_program(5) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            vm.set_trace_mode(false);
+            vm.add_tracepoint(program.starting_point);
+            print_program(vm.interpret());
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+
+        try {
+            // Past the end of the bytecode, so this should be rejected.
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            vm.add_tracepoint(static_cast<int>(program.bytecode.size()));
+            print_program(vm.interpret());
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void profile_opcodes() {
+        constexpr std::string_view test_profile { "test_opcode_profile.txt" };
+        const Program& program { *get_demo_program(5) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Opcode_Profile profile {};
+
+            {
+                Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+                vm.set_trace_mode(false);
+                vm.set_opcode_profile(&profile);
+                print_program(vm.interpret());
+            }
+
+            profile.print_summary(std::cout, 5);
+            profile.merge_into(test_profile);
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void sample_program() {
+        constexpr std::string_view test_profile { "test_sampling_profile.txt" };
+        const Program& program { *get_demo_program(5) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            Sampling_Profiler profiler { 100 };
+
+            vm.set_trace_mode(false);
+            vm.set_sampling_profiler(&profiler);
+            print_program(vm.interpret());
+            profiler.stop();
+
+            // Demo programs finish within a few timer ticks, so how many samples land varies from run to run.
+            profiler.save_collapsed_stacks(test_profile);
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void profile_calls() {
+        const Program& program { *get_demo_program(4) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            Call_Profile profile {};
+
+            vm.set_trace_mode(false);
+            vm.set_call_profile(&profile);
+            print_program(vm.interpret());
+
+            profile.finish(vm.get_instructions_retired());
+            profile.print_report(std::cout, Line_Table {});
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void record_coverage() {
+        constexpr std::string_view test_coverage { "test_coverage.txt" };
+        const Program& program { *get_demo_program(1) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            Coverage coverage {};
+
+            vm.set_trace_mode(false);
+            vm.set_coverage(&coverage);
+            print_program(vm.interpret());
+
+            std::cout << "Merged: " << std::boolalpha << coverage.merge_into(test_coverage, Line_Table {}) << '\n';
+            coverage.print_summary(std::cout, Line_Table {});
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void record_timeline() {
+        constexpr std::string_view test_timeline { "test_timeline.json" };
+        const Program& program { *get_demo_program(4) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            Timeline timeline { 4, 0 };
+
+            vm.set_trace_mode(false);
+            vm.set_timeline(&timeline);
+            print_program(vm.interpret());
+
+            timeline.finish();
+            timeline.save(test_timeline, Line_Table {});
+
+            std::ifstream saved { std::string(test_timeline) };
+            std::string line {};
+            int calls {};
+
+            while (std::getline(saved, line)) {
+                calls += (line.find("\"cat\":\"call\"") != std::string::npos);
+            }
+
+            std::cout << "Calls saved: " << calls << ", dropped: " << timeline.get_dropped_calls() << '\n';
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    void publish_live_metrics() {
+        const Program& program { *get_demo_program(5) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            Live_Metrics metrics { "./test_live_metrics", 1 };
+
+            vm.set_trace_mode(false);
+            vm.set_live_metrics(&metrics);
+            print_program(vm.interpret());
+
+            vm.publish_live_metrics();
+            metrics.finish();
+            Live_Metrics::watch("./test_live_metrics", std::cout);
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
+    bool run_without_allocating() {
+        const Program& program { *get_demo_program(5) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            vm.set_trace_mode(false);
+
+            const Allocation_Counts start { get_allocation_counts() };
+            const Application::Status result { vm.interpret() };
+            const Allocation_Counts allocated { get_allocation_counts() - start };
+
+            print_program(result);
+
+            if (allocated.allocations == 0) {
+                std::cout << "PASSED: No heap allocations during execution.\n";
+                return true;
+            }
+
+            std::cout << "FAILED: " << allocated.allocations << " allocations (" << allocated.bytes << " bytes) during execution.\n";
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+
+        return false;
+    }
+
+    void report_memory() {
+        const Program& program { *get_demo_program(0) };
+
+        try {
+            std::cout << "\n---------- " << program.name << '\n';
+            Virtual_Machine vm { std::vector<int> { program.bytecode }, program.starting_point, new Console_Logger() };
+            vm.set_trace_mode(false);
+
+            const Application::Status result { vm.interpret() };
+            const Memory_Report memory { vm.get_memory_report() };
+
+            print_program(result);
+            std::cout
+                << "Code bytes: " << memory.code_bytes
+                << ", stack values: " << memory.stack_capacity
+                << ", call frames: " << memory.call_stack_capacity
+                << ", globals: " << memory.global_values << " (" << memory.globals_referenced << " named)"
+                << ", output buffer bytes: " << memory.output_buffer_bytes
+                << ", total bytes: " << memory.get_total_bytes() << '\n';
+        }
+        catch (const std::exception& exception) {
+            std::cout << exception.what() << '\n';
+        }
+    }
+
     void dump_code_to_console() {
         dump_code(get_demo_program(0));
     }
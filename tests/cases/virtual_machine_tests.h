@@ -10,5 +10,18 @@ namespace test {
     void run_fibonacci();
 
     void output_to_file();
+    void output_to_file_async();
+    void output_to_file_mapped();
+    void trace_to_file();
+    void run_tracepoints();
+    void profile_opcodes();
+    void sample_program();
+    void profile_calls();
+    void record_coverage();
+    void record_timeline();
+    void publish_live_metrics();
+    // Returns false if running a program allocated anything on the heap.
+    bool run_without_allocating();
+    void report_memory();
     void dump_code_to_console();
 }
@@ -2,12 +2,15 @@
 #include "virtual_machine_tests.h"
 #include "parser_tests.h"
 #include "application_tests.h"
+#include "optimizer_tests.h"
 
 static void space() {
     std::cout << "\n\n\n\n\n";
 }
 
 int main(int argc, const char* argv[]) {
+    bool allocation_free {};
+
     /* Virtual Machine */ {
         test::run_basic_instructions();
         space();
@@ -23,6 +26,30 @@ int main(int argc, const char* argv[]) {
         space();
         test::output_to_file();
         space();
+        test::output_to_file_async();
+        space();
+        test::output_to_file_mapped();
+        space();
+        test::trace_to_file();
+        space();
+        test::run_tracepoints();
+        space();
+        test::profile_opcodes();
+        space();
+        test::sample_program();
+        space();
+        test::profile_calls();
+        space();
+        test::record_coverage();
+        space();
+        test::record_timeline();
+        space();
+        test::publish_live_metrics();
+        space();
+        allocation_free = test::run_without_allocating();
+        space();
+        test::report_memory();
+        space();
         test::dump_code_to_console();
         space();
     }
@@ -35,11 +62,32 @@ int main(int argc, const char* argv[]) {
         test::fail_to_load_nonsvim_file();
     }
 
+    /* Optimizer */ {
+        test::run_tail_calls();
+        space();
+        test::run_unrolled_loops();
+        space();
+        test::run_unrolled_loop_bounds();
+        space();
+        test::run_constant_calls();
+        space();
+        test::run_strength_reduction();
+        space();
+        test::run_block_layout();
+        space();
+        test::map_line_table();
+        space();
+    }
+
     /* Application */ {
         test::print_help();
         space();
         test::run_program_to_console();
         space();
+        test::run_program_with_stats();
+        space();
+        test::benchmark_program();
+        space();
         test::run_program_to_file();
         space();
         test::run_example_program();
@@ -63,5 +111,5 @@ int main(int argc, const char* argv[]) {
         space();
     }
 
-    return 0;
+    return (allocation_free) ? 0 : 1;
 }